@@ -0,0 +1,274 @@
+/*
+ * Copyright (c) 2026 Li Ruijie
+ * Licensed under the GNU General Public License v3.0.
+ */
+
+#include "batch.h"
+#include <limits.h>
+#include <stdlib.h>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define BATCH_X86 1
+#include <emmintrin.h>
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define BATCH_TARGET_AVX2
+#else
+#include <cpuid.h>
+#define BATCH_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+static BatchMapFn g_batch_fn = batch_map_scalar;
+static const wchar_t *g_batch_name = L"scalar";
+
+/* ========== Scalar reference ========== */
+
+static int nearest_index(const BatchParams *p, int ad) {
+    for (int i = 0; i < p->accel_count; i++) {
+        if (p->threshold[i] == ad) return i;
+        if (p->threshold[i] > ad) {
+            if (i == 0) return 0;
+            return (p->threshold[i] - ad < abs(p->threshold[i - 1] - ad)) ? i : i - 1;
+        }
+    }
+    return p->accel_count - 1;
+}
+
+/* Saturating: INT_MIN maps to INT_MAX, so the result can always be negated */
+static int magnitude(int d) {
+    return d == INT_MIN ? INT_MAX : abs(d);
+}
+
+/* Truncation is symmetric, so the table holds magnitudes only */
+static int accel(const BatchParams *p, int d) {
+    int ad = magnitude(d), m;
+    if (ad < BATCH_LUT_SIZE) {
+        m = p->lut[ad];
+    } else if (p->accel_count == 0) {
+        m = ad;
+    } else {
+        double x = (double)ad * p->multiplier[nearest_index(p, ad)];
+        m = x >= (double)INT_MAX ? INT_MAX : x <= -(double)INT_MAX ? -INT_MAX : (int)x;
+    }
+    return d < 0 ? -m : m;
+}
+
+void batch_map_scalar(const BatchParams *p, const LONG *xs, const LONG *ys,
+                      const int *tx, const int *ty, int count, int *v_out, int *h_out) {
+    const LONG *fx = p->swap ? ys : xs, *fy = p->swap ? xs : ys;
+    const int *dx = p->swap ? ty : tx, *dy = p->swap ? tx : ty;
+    for (int i = 0; i < count; i++) {
+        v_out[i] = magnitude(dy[i]) > p->vert_thr ? p->v_sign * accel(p, (int)fy[i]) : 0;
+        h_out[i] = (p->horiz_enabled && magnitude(dx[i]) > p->horiz_thr) ?
+                   p->h_sign * accel(p, (int)fx[i]) : 0;
+    }
+}
+
+void batch_prepare(BatchParams *p, const int *threshold, const double *multiplier,
+                   int accel_count, BOOL reverse, BOOL swap,
+                   int vert_thr, int horiz_thr, BOOL horiz_enabled) {
+    p->threshold = threshold;
+    p->multiplier = multiplier;
+    p->accel_count = accel_count;
+    for (int a = 0; a < BATCH_LUT_SIZE; a++)
+        p->lut[a] = accel_count ? (int)((double)a * multiplier[nearest_index(p, a)]) : a;
+    p->v_sign = reverse ? 1 : -1;
+    p->h_sign = reverse ? -1 : 1;
+    p->vert_thr = vert_thr;
+    p->horiz_thr = horiz_thr;
+    p->horiz_enabled = horiz_enabled;
+    p->swap = swap;
+}
+
+#ifdef BATCH_X86
+
+/* ========== SSE2 (4 lanes; table lookups stay scalar) ========== */
+
+/* Saturating, as magnitude(): the wrapped abs(INT_MIN) is pulled back to INT_MAX */
+static __m128i abs_sse2(__m128i v) {
+    __m128i s = _mm_srai_epi32(v, 31);
+    __m128i a = _mm_sub_epi32(_mm_xor_si128(v, s), s);
+    return _mm_add_epi32(a, _mm_srai_epi32(a, 31));
+}
+
+/* Apply the sign of d, then the axis sign mask (0 or -1) */
+static __m128i sign_sse2(__m128i mag, __m128i d, __m128i axis) {
+    __m128i s = _mm_xor_si128(_mm_srai_epi32(d, 31), axis);
+    return _mm_sub_epi32(_mm_xor_si128(mag, s), s);
+}
+
+static __m128i lookup_sse2(const int *lut, __m128i a) {
+    int i[4];
+    _mm_storeu_si128((__m128i *)i, a);
+    return _mm_set_epi32(lut[i[3]], lut[i[2]], lut[i[1]], lut[i[0]]);
+}
+
+static void batch_map_sse2(const BatchParams *p, const LONG *xs, const LONG *ys,
+                           const int *tx, const int *ty, int count, int *v_out, int *h_out) {
+    const LONG *fx = p->swap ? ys : xs, *fy = p->swap ? xs : ys;
+    const int *dx = p->swap ? ty : tx, *dy = p->swap ? tx : ty;
+    const __m128i vthr = _mm_set1_epi32(p->vert_thr);
+    const __m128i hthr = _mm_set1_epi32(p->horiz_thr);
+    const __m128i hen = _mm_set1_epi32(p->horiz_enabled ? -1 : 0);
+    const __m128i vneg = _mm_set1_epi32(p->v_sign < 0 ? -1 : 0);
+    const __m128i hneg = _mm_set1_epi32(p->h_sign < 0 ? -1 : 0);
+    const __m128i lmax = _mm_set1_epi32(BATCH_LUT_SIZE - 1);
+    __m128i big = _mm_setzero_si128();
+    int i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        __m128i vy = _mm_loadu_si128((const __m128i *)(fy + i));
+        __m128i vx = _mm_loadu_si128((const __m128i *)(fx + i));
+        __m128i ay = abs_sse2(vy), ax = abs_sse2(vx);
+
+        /* Clamp table indices; out-of-table lanes are redone in scalar */
+        __m128i gy = _mm_cmpgt_epi32(ay, lmax);
+        __m128i gx = _mm_cmpgt_epi32(ax, lmax);
+        big = _mm_or_si128(big, _mm_or_si128(gy, gx));
+        ay = _mm_or_si128(_mm_andnot_si128(gy, ay), _mm_and_si128(gy, lmax));
+        ax = _mm_or_si128(_mm_andnot_si128(gx, ax), _mm_and_si128(gx, lmax));
+
+        __m128i v = sign_sse2(lookup_sse2(p->lut, ay), vy, vneg);
+        __m128i h = sign_sse2(lookup_sse2(p->lut, ax), vx, hneg);
+
+        __m128i vm = _mm_cmpgt_epi32(abs_sse2(_mm_loadu_si128((const __m128i *)(dy + i))), vthr);
+        __m128i hm = _mm_and_si128(hen,
+            _mm_cmpgt_epi32(abs_sse2(_mm_loadu_si128((const __m128i *)(dx + i))), hthr));
+
+        _mm_storeu_si128((__m128i *)(v_out + i), _mm_and_si128(v, vm));
+        _mm_storeu_si128((__m128i *)(h_out + i), _mm_and_si128(h, hm));
+    }
+
+    if (_mm_movemask_epi8(big))
+        batch_map_scalar(p, xs, ys, tx, ty, i, v_out, h_out);
+    if (i < count)
+        batch_map_scalar(p, xs + i, ys + i, tx + i, ty + i, count - i, v_out + i, h_out + i);
+}
+
+/* ========== AVX2 (8 lanes, gathered table lookups) ========== */
+
+BATCH_TARGET_AVX2
+static __m256i abs_avx2(__m256i v) {
+    __m256i a = _mm256_abs_epi32(v);
+    return _mm256_add_epi32(a, _mm256_srai_epi32(a, 31));
+}
+
+BATCH_TARGET_AVX2
+static void batch_map_avx2(const BatchParams *p, const LONG *xs, const LONG *ys,
+                           const int *tx, const int *ty, int count, int *v_out, int *h_out) {
+    const LONG *fx = p->swap ? ys : xs, *fy = p->swap ? xs : ys;
+    const int *dx = p->swap ? ty : tx, *dy = p->swap ? tx : ty;
+    const __m256i vthr = _mm256_set1_epi32(p->vert_thr);
+    const __m256i hthr = _mm256_set1_epi32(p->horiz_thr);
+    const __m256i hen = _mm256_set1_epi32(p->horiz_enabled ? -1 : 0);
+    const __m256i vsign = _mm256_set1_epi32(p->v_sign);
+    const __m256i hsign = _mm256_set1_epi32(p->h_sign);
+    const __m256i lmax = _mm256_set1_epi32(BATCH_LUT_SIZE - 1);
+    const __m256i ones = _mm256_set1_epi32(-1);
+    __m256i big = _mm256_setzero_si256();
+    int i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m256i vy = _mm256_loadu_si256((const __m256i *)(fy + i));
+        __m256i vx = _mm256_loadu_si256((const __m256i *)(fx + i));
+        __m256i ay = abs_avx2(vy), ax = abs_avx2(vx);
+
+        __m256i cy = _mm256_min_epu32(ay, lmax), cx = _mm256_min_epu32(ax, lmax);
+        big = _mm256_or_si256(big, _mm256_or_si256(
+            _mm256_xor_si256(_mm256_cmpeq_epi32(cy, ay), ones),
+            _mm256_xor_si256(_mm256_cmpeq_epi32(cx, ax), ones)));
+        ay = cy;
+        ax = cx;
+
+        /* sign_epi32 also zeroes lanes whose delta is 0 */
+        __m256i v = _mm256_sign_epi32(_mm256_sign_epi32(_mm256_i32gather_epi32(p->lut, ay, 4), vy), vsign);
+        __m256i h = _mm256_sign_epi32(_mm256_sign_epi32(_mm256_i32gather_epi32(p->lut, ax, 4), vx), hsign);
+
+        __m256i vm = _mm256_cmpgt_epi32(abs_avx2(_mm256_loadu_si256((const __m256i *)(dy + i))), vthr);
+        __m256i hm = _mm256_and_si256(hen,
+            _mm256_cmpgt_epi32(abs_avx2(_mm256_loadu_si256((const __m256i *)(dx + i))), hthr));
+
+        _mm256_storeu_si256((__m256i *)(v_out + i), _mm256_and_si256(v, vm));
+        _mm256_storeu_si256((__m256i *)(h_out + i), _mm256_and_si256(h, hm));
+    }
+
+    if (!_mm256_testz_si256(big, big))
+        batch_map_scalar(p, xs, ys, tx, ty, i, v_out, h_out);
+    if (i < count)
+        batch_map_scalar(p, xs + i, ys + i, tx + i, ty + i, count - i, v_out + i, h_out + i);
+}
+
+/* ========== CPU feature detection ========== */
+
+static void cpuid(int leaf, int sub, int r[4]) {
+#ifdef _MSC_VER
+    __cpuidex(r, leaf, sub);
+#else
+    unsigned a = 0, b = 0, c = 0, d = 0;
+    __cpuid_count((unsigned)leaf, (unsigned)sub, a, b, c, d);
+    r[0] = (int)a; r[1] = (int)b; r[2] = (int)c; r[3] = (int)d;
+#endif
+}
+
+static unsigned long long xgetbv0(void) {
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    unsigned lo, hi;
+    __asm__ volatile ("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return ((unsigned long long)hi << 32) | lo;
+#endif
+}
+
+static BOOL has_sse2(void) {
+    int r[4];
+    cpuid(1, 0, r);
+    return (r[3] & (1 << 26)) != 0;
+}
+
+/* AVX2 needs CPU support and OS-saved YMM state (XCR0 bits 1 and 2) */
+static BOOL has_avx2(void) {
+    int r[4];
+    cpuid(0, 0, r);
+    if (r[0] < 7) return FALSE;
+    cpuid(1, 0, r);
+    if ((r[2] & (1 << 27)) == 0 || (r[2] & (1 << 28)) == 0) return FALSE;
+    if ((xgetbv0() & 6) != 6) return FALSE;
+    cpuid(7, 0, r);
+    return (r[1] & (1 << 5)) != 0;
+}
+
+#endif /* BATCH_X86 */
+
+void batch_init(void) {
+#ifdef BATCH_X86
+    if (has_avx2()) {
+        g_batch_fn = batch_map_avx2;
+        g_batch_name = L"avx2";
+    } else if (has_sse2()) {
+        g_batch_fn = batch_map_sse2;
+        g_batch_name = L"sse2";
+    }
+#endif
+}
+
+void batch_map(const BatchParams *p, const LONG *xs, const LONG *ys,
+               const int *tx, const int *ty, int count, int *v_out, int *h_out) {
+    g_batch_fn(p, xs, ys, tx, ty, count, v_out, h_out);
+}
+
+const wchar_t *batch_kernel_name(void) {
+    return g_batch_name;
+}
+
+int batch_kernels(BatchMapFn *fns, const wchar_t **names, int max) {
+    int n = 0;
+    if (n < max) { fns[n] = batch_map_scalar; names[n++] = L"scalar"; }
+#ifdef BATCH_X86
+    if (n < max && has_sse2()) { fns[n] = batch_map_sse2; names[n++] = L"sse2"; }
+    if (n < max && has_avx2()) { fns[n] = batch_map_avx2; names[n++] = L"avx2"; }
+#endif
+    return n;
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2026 Li Ruijie
+ * Licensed under the GNU General Public License v3.0.
+ */
+
+#ifndef W10WHEEL_BATCH_H
+#define W10WHEEL_BATCH_H
+
+#include <windows.h>
+
+/*
+ * Batch kernel for direct (non real wheel) standard scrolling: swap,
+ * threshold test, acceleration, reverse and V/H routing over a whole
+ * raw-input batch in one pass. SSE2/AVX2 variants are picked at runtime,
+ * with a scalar fallback that defines the reference result.
+ */
+
+/* Accelerated magnitudes below this come from a table */
+#define BATCH_LUT_SIZE 1024
+
+typedef struct {
+    int  lut[BATCH_LUT_SIZE];
+    const int    *threshold;   /* for magnitudes past the table */
+    const double *multiplier;
+    int  accel_count;          /* 0 = acceleration off */
+    int  v_sign, h_sign;       /* +1 or -1 (reverse) */
+    int  vert_thr, horiz_thr;
+    BOOL horiz_enabled;
+    BOOL swap;
+} BatchParams;
+
+void batch_init(void);
+void batch_prepare(BatchParams *p, const int *threshold, const double *multiplier,
+                   int accel_count, BOOL reverse, BOOL swap,
+                   int vert_thr, int horiz_thr, BOOL horiz_enabled);
+
+/*
+ * xs/ys: per-report deltas; tx/ty: running totals after each report.
+ * v_out/h_out: wheel delta per report and axis, 0 = nothing to send.
+ * Magnitudes saturate: INT_MIN counts as INT_MAX, so any int is valid.
+ */
+void batch_map(const BatchParams *p, const LONG *xs, const LONG *ys,
+               const int *tx, const int *ty, int count, int *v_out, int *h_out);
+
+/* Reference implementation, always available */
+void batch_map_scalar(const BatchParams *p, const LONG *xs, const LONG *ys,
+                      const int *tx, const int *ty, int count, int *v_out, int *h_out);
+
+typedef void (*BatchMapFn)(const BatchParams *p, const LONG *xs, const LONG *ys,
+                           const int *tx, const int *ty, int count, int *v_out, int *h_out);
+
+/* Every kernel this CPU can run, scalar first, for checks against the reference */
+int batch_kernels(BatchMapFn *fns, const wchar_t **names, int max);
+
+const wchar_t *batch_kernel_name(void);
+
+#endif
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2026 Li Ruijie
+ * Licensed under the GNU General Public License v3.0.
+ */
+
+#ifndef W10WHEEL_CFGSCHEMA_H
+#define W10WHEEL_CFGSCHEMA_H
+
+/*
+ * Settings schema: one row per INI key, in file order. Everything keyed by
+ * setting name (storage slots, defaults, ranges, the INI mapping and the
+ * name lookup tables) is generated from this list.
+ *
+ *   S(id, section, ini_key, name)                   string, parsed by its setter
+ *   B(id, section, ini_key, name, def)              boolean
+ *   N(id, section, ini_key, name, low, up, def)     number, valid in [low, up]
+ */
+#define CFG_SCHEMA(S, B, N) \
+    /* General */ \
+    S(TRIGGER,               L"General", L"trigger",               L"firstTrigger") \
+    B(SEND_MIDDLE_CLICK,     L"General", L"send_middle_click",     L"sendMiddleClick",     FALSE) \
+    B(DRAGGED_LOCK,          L"General", L"dragged_lock",          L"draggedLock",         FALSE) \
+    B(KEYBOARD_HOOK,         L"General", L"keyboard_hook",         L"keyboardHook",        FALSE) \
+    S(TARGET_VK_CODE,        L"General", L"vk_code",               L"targetVKCode") \
+    S(PROCESS_PRIORITY,      L"General", L"priority",              L"processPriority") \
+    N(HOOK_HEALTH_CHECK,     L"General", L"health_check_interval", L"hookHealthCheck",     0, 300, 0) \
+    /* Scroll */ \
+    B(CURSOR_CHANGE,         L"Scroll", L"cursor_change",          L"cursorChange",        TRUE) \
+    B(HORIZONTAL_SCROLL,     L"Scroll", L"horizontal_scroll",      L"horizontalScroll",    TRUE) \
+    B(REVERSE_SCROLL,        L"Scroll", L"reverse_scroll",         L"reverseScroll",       FALSE) \
+    B(SWAP_SCROLL,           L"Scroll", L"swap_scroll",            L"swapScroll",          FALSE) \
+    B(RAW_INPUT_PERSISTENT,  L"Scroll", L"persistent_raw_input",   L"rawInputPersistent",  FALSE) \
+    S(RAW_DEVICE_ALLOW,      L"Scroll", L"raw_device_allow",       L"rawDeviceAllow") \
+    N(POLL_TIMEOUT,          L"Scroll", L"poll_timeout",           L"pollTimeout",         50, 500, 200) \
+    N(SCROLL_LOCKTIME,       L"Scroll", L"scroll_lock_time",       L"scrollLocktime",      150, 500, 200) \
+    N(VERTICAL_THRESHOLD,    L"Scroll", L"vertical_threshold",     L"verticalThreshold",   0, 500, 0) \
+    N(HORIZONTAL_THRESHOLD,  L"Scroll", L"horizontal_threshold",   L"horizontalThreshold", 0, 500, 75) \
+    N(DRAG_THRESHOLD,        L"Scroll", L"drag_threshold",         L"dragThreshold",       0, 500, 0) \
+    /* Acceleration */ \
+    B(ACCEL_TABLE,           L"Acceleration", L"accel_table",             L"accelTable",            TRUE) \
+    S(ACCEL_MULTIPLIER,      L"Acceleration", L"multiplier",              L"accelMultiplier") \
+    B(CUSTOM_ACCEL_TABLE,    L"Acceleration", L"custom_accel_table",      L"customAccelTable",      FALSE) \
+    S(CUSTOM_ACCEL_THRESHOLD,  L"Acceleration", L"custom_accel_threshold",  L"customAccelThreshold") \
+    S(CUSTOM_ACCEL_MULTIPLIER, L"Acceleration", L"custom_accel_multiplier", L"customAccelMultiplier") \
+    /* Real Wheel */ \
+    B(REAL_WHEEL_MODE,       L"Real Wheel", L"real_wheel_mode",    L"realWheelMode",   FALSE) \
+    N(WHEEL_DELTA,           L"Real Wheel", L"wheel_delta",        L"wheelDelta",      10, 500, 120) \
+    N(V_WHEEL_MOVE,          L"Real Wheel", L"vertical_speed",     L"vWheelMove",      10, 500, 60) \
+    N(H_WHEEL_MOVE,          L"Real Wheel", L"horizontal_speed",   L"hWheelMove",      10, 500, 60) \
+    B(QUICK_FIRST,           L"Real Wheel", L"quick_first",        L"quickFirst",      FALSE) \
+    B(QUICK_TURN,            L"Real Wheel", L"quick_turn",         L"quickTurn",       FALSE) \
+    /* VH Adjuster */ \
+    B(VH_ADJUSTER_MODE,      L"VH Adjuster", L"vh_adjuster_mode",    L"vhAdjusterMode",      FALSE) \
+    S(VH_ADJUSTER_METHOD,    L"VH Adjuster", L"method",              L"vhAdjusterMethod") \
+    B(FIRST_PREFER_VERTICAL, L"VH Adjuster", L"prefer_vertical",     L"firstPreferVertical", TRUE) \
+    N(FIRST_MIN_THRESHOLD,   L"VH Adjuster", L"min_threshold",       L"firstMinThreshold",   1, 10, 5) \
+    N(SWITCHING_THRESHOLD,   L"VH Adjuster", L"switching_threshold", L"switchingThreshold",  10, 500, 50) \
+    /* Keyboard */ \
+    N(KB_REPEAT_DELAY,       L"Keyboard", L"character_repeat_delay",       L"kbRepeatDelay",        0, 3, 1) \
+    N(KB_REPEAT_SPEED,       L"Keyboard", L"character_repeat_speed",       L"kbRepeatSpeed",        0, 31, 31) \
+    B(FILTER_KEYS,           L"Keyboard", L"filter_keys",                  L"filterKeys",           FALSE) \
+    B(FK_LOCK,               L"Keyboard", L"filter_keys_lock",             L"fkLock",               FALSE) \
+    N(FK_ACCEPTANCE_DELAY,   L"Keyboard", L"filter_keys_acceptance_delay", L"fkAcceptanceDelay",    0, 10000, 1000) \
+    N(FK_REPEAT_DELAY,       L"Keyboard", L"filter_keys_repeat_delay",     L"fkRepeatDelay",        0, 10000, 1000) \
+    N(FK_REPEAT_RATE,        L"Keyboard", L"filter_keys_repeat_rate",      L"fkRepeatRate",         0, 10000, 500) \
+    N(FK_BOUNCE_TIME,        L"Keyboard", L"filter_keys_bounce_time",      L"fkBounceTime",         0, 10000, 0) \
+    B(SW_REPEAT,             L"Keyboard", L"software_repeat",              L"swRepeat",             FALSE) \
+    N(SW_REPEAT_DELAY,       L"Keyboard", L"software_repeat_delay",        L"swRepeatDelay",        50, 2000, 500) \
+    N(SW_REPEAT_INTERVAL,    L"Keyboard", L"software_repeat_interval",     L"swRepeatInterval",     5, 1000, 33) \
+    N(SW_REPEAT_NAV_DELAY,   L"Keyboard", L"nav_repeat_delay",             L"swRepeatNavDelay",     50, 2000, 250) \
+    N(SW_REPEAT_NAV_INTERVAL,  L"Keyboard", L"nav_repeat_interval",        L"swRepeatNavInterval",  5, 1000, 16) \
+    N(SW_REPEAT_EDIT_DELAY,  L"Keyboard", L"edit_repeat_delay",            L"swRepeatEditDelay",    50, 2000, 500) \
+    N(SW_REPEAT_EDIT_INTERVAL, L"Keyboard", L"edit_repeat_interval",       L"swRepeatEditInterval", 5, 1000, 50) \
+    N(DEBOUNCE_TIME,         L"Keyboard", L"debounce_time",                L"debounceTime",         0, 255, 0) \
+    S(DEBOUNCE_KEYS,         L"Keyboard", L"debounce_keys",                L"debounceKeys")
+
+#define CFG_SCHEMA_NONE(...)
+
+/* Storage slots: CFG_B_* index the boolean array, CFG_N_* the number array */
+#define CFG_SCHEMA_B_ID(id, sec, key, name, def) CFG_B_##id,
+#define CFG_SCHEMA_N_ID(id, sec, key, name, lo, up, def) CFG_N_##id,
+
+typedef enum {
+    CFG_SCHEMA(CFG_SCHEMA_NONE, CFG_SCHEMA_B_ID, CFG_SCHEMA_NONE)
+    CFG_BOOL_COUNT
+} CfgBoolId;
+
+typedef enum {
+    CFG_SCHEMA(CFG_SCHEMA_NONE, CFG_SCHEMA_NONE, CFG_SCHEMA_N_ID)
+    CFG_NUM_COUNT
+} CfgNumId;
+
+#undef CFG_SCHEMA_B_ID
+#undef CFG_SCHEMA_N_ID
+
+#endif
@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2026 Li Ruijie
+ * Licensed under the GNU General Public License v3.0.
+ */
+
+#include "cfgsnap.h"
+#include <stdlib.h>
+
+#ifdef _MSC_VER
+#define TPKB_THREAD_LOCAL __declspec(thread)
+#else
+#define TPKB_THREAD_LOCAL __thread
+#endif
+
+#define SNAP_READER_SLOTS  16
+#define SNAP_GRACE_MS      1000
+
+/* Precedes each snapshot; a multiple of 16 so the payload keeps malloc alignment */
+typedef struct SnapHeader {
+    struct SnapHeader *next;    /* retired list, newest first */
+    LONG   epoch;               /* pins at or past this epoch cannot hold it */
+    DWORD  time;
+} SnapHeader;
+#define SNAP_HEADER_SIZE 32
+
+static void *volatile g_current = NULL;
+static void          *g_boot = NULL;
+static DWORD          g_owner = 0;
+
+/* Reader epochs: 0 = slot not pinned */
+static volatile LONG  g_epoch = 1;
+static volatile LONG  g_reader_epoch[SNAP_READER_SLOTS];
+static volatile LONG  g_reader_slot_count = 0;
+static volatile LONG  g_overflow_pins = 0;  /* pins of threads without a slot */
+static TPKB_THREAD_LOCAL int t_reader_slot = -1;
+
+/* Replaced snapshots awaiting reclamation */
+static CRITICAL_SECTION g_retire_cs;
+static SnapHeader      *g_retired = NULL;
+
+static SnapHeader *header_of(void *snap) {
+    return (SnapHeader *)((char *)snap - SNAP_HEADER_SIZE);
+}
+
+void cfgsnap_init(void *boot) {
+    InitializeCriticalSection(&g_retire_cs);
+    g_boot = boot;
+    g_current = boot;
+    g_owner = GetCurrentThreadId();
+}
+
+/* ========== Readers ========== */
+
+void *cfgsnap_pin(void) {
+    if (t_reader_slot < 0) {
+        LONG n = InterlockedIncrement(&g_reader_slot_count);
+        t_reader_slot = n <= SNAP_READER_SLOTS ? (int)n - 1 : SNAP_READER_SLOTS;
+    }
+    /* The pin is visible before the load: a writer that missed it had
+       already swapped, so the load returns the new snapshot */
+    if (t_reader_slot < SNAP_READER_SLOTS)
+        InterlockedExchange(&g_reader_epoch[t_reader_slot], g_epoch);
+    else
+        InterlockedIncrement(&g_overflow_pins);
+    return InterlockedCompareExchangePointer((PVOID volatile *)&g_current, NULL, NULL);
+}
+
+void cfgsnap_unpin(void) {
+    if (t_reader_slot < SNAP_READER_SLOTS)
+        InterlockedExchange(&g_reader_epoch[t_reader_slot], 0);
+    else
+        InterlockedDecrement(&g_overflow_pins);
+}
+
+void *cfgsnap_current(void) {
+    return InterlockedCompareExchangePointer((PVOID volatile *)&g_current, NULL, NULL);
+}
+
+BOOL cfgsnap_is_owner(void) {
+    return GetCurrentThreadId() == g_owner;
+}
+
+/* ========== Writers ========== */
+
+void *cfgsnap_alloc(size_t size) {
+    char *p = (char *)malloc(SNAP_HEADER_SIZE + size);
+    return p ? p + SNAP_HEADER_SIZE : NULL;
+}
+
+static BOOL reader_may_hold(LONG epoch) {
+    if (g_overflow_pins > 0) return TRUE;
+    LONG n = g_reader_slot_count;
+    if (n > SNAP_READER_SLOTS) n = SNAP_READER_SLOTS;
+    for (int i = 0; i < n; i++) {
+        LONG e = g_reader_epoch[i];
+        if (e != 0 && e < epoch) return TRUE;
+    }
+    return FALSE;
+}
+
+/* Owner thread, under g_retire_cs */
+static void reclaim(BOOL force) {
+    DWORD now = GetTickCount();
+    SnapHeader **link = &g_retired;
+    while (*link) {
+        SnapHeader *h = *link;
+        if (!reader_may_hold(h->epoch) &&
+            (force || now - h->time >= SNAP_GRACE_MS)) {
+            *link = h->next;
+            free(h);
+        } else {
+            link = &h->next;
+        }
+    }
+}
+
+void cfgsnap_publish(void *nw) {
+    void *old = InterlockedExchangePointer((PVOID volatile *)&g_current, nw);
+    LONG epoch = InterlockedIncrement(&g_epoch);
+
+    EnterCriticalSection(&g_retire_cs);
+    if (old != g_boot) {
+        SnapHeader *h = header_of(old);
+        h->epoch = epoch;
+        h->time = GetTickCount();
+        h->next = g_retired;
+        g_retired = h;
+    }
+    /* Other writers only queue; the owner frees at its next publish */
+    if (cfgsnap_is_owner()) reclaim(FALSE);
+    LeaveCriticalSection(&g_retire_cs);
+}
+
+void cfgsnap_cleanup(void) {
+    if (!cfgsnap_is_owner()) return;
+    EnterCriticalSection(&g_retire_cs);
+    reclaim(TRUE);
+    LeaveCriticalSection(&g_retire_cs);
+}
@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2026 Li Ruijie
+ * Licensed under the GNU General Public License v3.0.
+ */
+
+#ifndef W10WHEEL_CFGSNAP_H
+#define W10WHEEL_CFGSNAP_H
+
+#include <windows.h>
+
+/*
+ * Publication of immutable settings snapshots: one current pointer,
+ * swapped by writers, pinned by readers. A replaced snapshot is freed
+ * once no pinned reader can hold it (epochs) and a grace period has
+ * passed.
+ *
+ * Who may read what:
+ * - The owner thread (the one calling cfgsnap_init; the UI thread) may
+ *   use cfgsnap_current() unpinned. Snapshots are only freed on the owner
+ *   thread, so none can vanish under its reads. It must not keep a
+ *   snapshot pointer across its own publish.
+ * - Every other thread pins (cfgsnap_pin/unpin) around its reads. Pins
+ *   past the per-thread slots fall back to a shared counter that holds
+ *   back every free, so a pin is always honoured.
+ * - The grace period is only a safety net for a stray unpinned read.
+ */
+
+/* boot: initial snapshot (static), never freed */
+void  cfgsnap_init(void *boot);
+
+/* Owner thread: frees every retired snapshot no longer pinned */
+void  cfgsnap_cleanup(void);
+
+void *cfgsnap_pin(void);      /* current snapshot, valid until the unpin */
+void  cfgsnap_unpin(void);
+void *cfgsnap_current(void);
+BOOL  cfgsnap_is_owner(void);  /* may this thread read unpinned */
+
+/* Snapshot storage; carries the link that retires it without allocating */
+void *cfgsnap_alloc(size_t size);
+
+/* Swaps in nw (from cfgsnap_alloc) and retires the previous snapshot */
+void  cfgsnap_publish(void *nw);
+
+#endif
@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2026 Li Ruijie
+ * Licensed under the GNU General Public License v3.0.
+ */
+
+#include "cfgstore.h"
+#include <process.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <wchar.h>
+
+#define FLUSH_TIMEOUT 2000  /* ms at exit */
+
+/* One per file with a write pending */
+typedef struct StoreRequest {
+    struct StoreRequest *next;
+    wchar_t path[MAX_PATH];
+    char   *data;
+    int     len;
+} StoreRequest;
+
+static StoreRequest *g_queue = NULL;    /* oldest first */
+static const StoreRequest *g_writing = NULL;    /* taken, being written */
+static CRITICAL_SECTION g_st_cs;
+static CRITICAL_SECTION g_st_file_cs;   /* one write_file at a time: they share temp names */
+static HANDLE g_st_event = NULL;    /* wakes the worker */
+static HANDLE g_st_idle = NULL;     /* set while nothing is pending or being written */
+static HANDLE g_st_thread = NULL;
+static volatile BOOL g_st_running = FALSE;
+
+/* The file the last write left behind, as the watcher will see it */
+static wchar_t  g_own_path[MAX_PATH];
+static DWORD    g_own_size_lo, g_own_size_hi;
+static FILETIME g_own_time;
+
+static void write_file(const wchar_t *path, const char *data, int len) {
+    wchar_t tmp[MAX_PATH + 8];
+    _snwprintf(tmp, MAX_PATH + 8, L"%s.tmp", path);
+    tmp[MAX_PATH + 7] = L'\0';
+
+    HANDLE f = CreateFileW(tmp, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+                           FILE_ATTRIBUTE_NORMAL, NULL);
+    if (f == INVALID_HANDLE_VALUE) return;
+
+    /* An explicit stamp is final: no deferred update at close moves it */
+    FILETIME now;
+    GetSystemTimeAsFileTime(&now);
+    DWORD written = 0;
+    BOOL ok = WriteFile(f, data, (DWORD)len, &written, NULL) &&
+              written == (DWORD)len && SetFileTime(f, NULL, NULL, &now) &&
+              FlushFileBuffers(f);
+    CloseHandle(f);
+
+    if (!ok || !MoveFileExW(tmp, path, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+        DeleteFileW(tmp);
+        return;
+    }
+
+    EnterCriticalSection(&g_st_cs);
+    wcsncpy(g_own_path, path, MAX_PATH - 1);
+    g_own_size_lo = (DWORD)len;
+    g_own_size_hi = 0;
+    g_own_time = now;
+    LeaveCriticalSection(&g_st_cs);
+}
+
+static StoreRequest *take_pending(void) {
+    EnterCriticalSection(&g_st_cs);
+    StoreRequest *req = g_queue;
+    if (req) g_queue = req->next;
+    g_writing = req;
+    LeaveCriticalSection(&g_st_cs);
+    return req;
+}
+
+static void drain(void) {
+    StoreRequest *req;
+    while ((req = take_pending()) != NULL) {
+        EnterCriticalSection(&g_st_file_cs);
+        write_file(req->path, req->data, req->len);
+        LeaveCriticalSection(&g_st_file_cs);
+        EnterCriticalSection(&g_st_cs);
+        g_writing = NULL;
+        LeaveCriticalSection(&g_st_cs);
+        free(req->data);
+        free(req);
+    }
+    EnterCriticalSection(&g_st_cs);
+    if (!g_queue) SetEvent(g_st_idle);
+    LeaveCriticalSection(&g_st_cs);
+}
+
+BOOL cfgstore_is_own_write(const wchar_t *path) {
+    WIN32_FILE_ATTRIBUTE_DATA fa;
+    BOOL have = GetFileAttributesExW(path, GetFileExInfoStandard, &fa);
+
+    EnterCriticalSection(&g_st_cs);
+    BOOL own = g_writing && wcscmp(g_writing->path, path) == 0;
+    for (const StoreRequest *r = g_queue; r && !own; r = r->next)
+        own = wcscmp(r->path, path) == 0;
+    if (!own && have && wcscmp(g_own_path, path) == 0)
+        own = fa.nFileSizeLow == g_own_size_lo && fa.nFileSizeHigh == g_own_size_hi &&
+              CompareFileTime(&fa.ftLastWriteTime, &g_own_time) == 0;
+    LeaveCriticalSection(&g_st_cs);
+    return own;
+}
+
+static unsigned __stdcall store_proc(void *arg) {
+    (void)arg;
+    for (;;) {
+        WaitForSingleObject(g_st_event, INFINITE);
+        drain();
+        if (!g_st_running) break;
+    }
+    return 0;
+}
+
+void cfgstore_write(const wchar_t *path, char *data, int len) {
+    /* Same file: replace its pending content. Another file: queue behind it */
+    EnterCriticalSection(&g_st_cs);
+    StoreRequest **link = &g_queue;
+    while (*link && wcscmp((*link)->path, path) != 0) link = &(*link)->next;
+    StoreRequest *req = *link;
+    if (req) {
+        free(req->data);    /* coalesced: superseded before it was written */
+    } else if ((req = (StoreRequest *)calloc(1, sizeof(StoreRequest))) != NULL) {
+        wcsncpy(req->path, path, MAX_PATH - 1);
+        *link = req;
+    }
+    if (req) {
+        req->data = data;
+        req->len = len;
+        if (g_st_idle) ResetEvent(g_st_idle);
+    }
+    LeaveCriticalSection(&g_st_cs);
+
+    if (!req) {
+        /* Out of memory for the queue entry: write it here rather than drop it */
+        EnterCriticalSection(&g_st_file_cs);
+        write_file(path, data, len);
+        LeaveCriticalSection(&g_st_file_cs);
+        free(data);
+        return;
+    }
+
+    /* Falls back to a synchronous write if the worker is not running */
+    if (g_st_thread) SetEvent(g_st_event);
+    else drain();
+}
+
+BOOL cfgstore_flush(DWORD timeout) {
+    if (!g_st_thread) return TRUE;
+    return WaitForSingleObject(g_st_idle, timeout) == WAIT_OBJECT_0;
+}
+
+/* ========== Init / cleanup ========== */
+
+void cfgstore_init(void) {
+    InitializeCriticalSection(&g_st_cs);
+    InitializeCriticalSection(&g_st_file_cs);
+    g_st_idle = CreateEventW(NULL, TRUE, TRUE, NULL);
+    g_st_event = CreateEventW(NULL, FALSE, FALSE, NULL);
+    if (!g_st_idle || !g_st_event) return;
+    g_st_running = TRUE;
+    g_st_thread = (HANDLE)_beginthreadex(NULL, 0, store_proc, NULL, 0, NULL);
+}
+
+void cfgstore_cleanup(void) {
+    g_st_running = FALSE;
+    if (g_st_event) SetEvent(g_st_event); /* Drain pending, then exit */
+    if (g_st_thread) {
+        /* A write still in flight past the bound leaves the old file intact */
+        WaitForSingleObject(g_st_thread, FLUSH_TIMEOUT);
+        CloseHandle(g_st_thread);
+        g_st_thread = NULL;
+    }
+}
@@ -0,0 +1,35 @@
+/*
+ * Copyright (c) 2026 Li Ruijie
+ * Licensed under the GNU General Public License v3.0.
+ */
+
+#ifndef W10WHEEL_CFGSTORE_H
+#define W10WHEEL_CFGSTORE_H
+
+#include <windows.h>
+
+/*
+ * Settings file writes, applied on a background worker in order. Writes
+ * to the same file coalesce (latest content wins); writes to different
+ * files queue, one entry per file, so none is dropped. Each lands through a flushed
+ * temp file and a write-through rename, so a cut-off write leaves the
+ * previous file intact.
+ */
+
+void cfgstore_init(void);
+void cfgstore_cleanup(void);  /* flushes pending writes, bounded */
+
+/* Takes ownership of data (malloc'd) */
+void cfgstore_write(const wchar_t *path, char *data, int len);
+
+/* Waits up to timeout ms for pending writes to land; TRUE if they did */
+BOOL cfgstore_flush(DWORD timeout);
+
+/*
+ * TRUE if path's state is this process's doing: a write to it is queued
+ * or in progress, or the file is still what the last write left (size
+ * and write time). A reload then would only lose newer in-memory changes.
+ */
+BOOL cfgstore_is_own_write(const wchar_t *path);
+
+#endif
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2026 Li Ruijie
+ * Licensed under the GNU General Public License v3.0.
+ */
+
+#include "cfgwatch.h"
+#include "config.h"
+#include "cfgstore.h"
+#include <process.h>
+#include <wchar.h>
+
+#define WATCH_DEBOUNCE  300     /* ms of quiet after the last change */
+#define WATCH_BUF_SIZE  4096
+
+static HANDLE g_watch_thread = NULL;
+static HANDLE g_watch_stop = NULL;
+static HWND   g_notify_hwnd = NULL;
+static UINT   g_notify_msg = 0;
+
+/* Editors often save through a temp file and a rename; any action counts */
+static BOOL names_file(const FILE_NOTIFY_INFORMATION *fni, const wchar_t *base) {
+    int len = (int)(fni->FileNameLength / sizeof(wchar_t));
+    return (int)wcslen(base) == len && _wcsnicmp(fni->FileName, base, len) == 0;
+}
+
+static BOOL batch_names_active_profile(const BYTE *buf) {
+    /* The name is snapshotted once per batch: the UI thread may switch it */
+    wchar_t path[MAX_PATH];
+    cfg_get_selected_properties_path(path, MAX_PATH);
+    const wchar_t *base = wcsrchr(path, L'\\');
+    base = base ? base + 1 : path;
+
+    const FILE_NOTIFY_INFORMATION *fni = (const FILE_NOTIFY_INFORMATION *)buf;
+    for (;;) {
+        if (names_file(fni, base)) return TRUE;
+        if (fni->NextEntryOffset == 0) return FALSE;
+        fni = (const FILE_NOTIFY_INFORMATION *)((const BYTE *)fni + fni->NextEntryOffset);
+    }
+}
+
+/*
+ * One directory read stays outstanding at a time. While a change is
+ * pending, each further change restarts the quiet period; the timeout
+ * ending it posts the notification.
+ */
+static unsigned __stdcall watch_proc(void *arg) {
+    HANDLE dir = (HANDLE)arg;
+    DWORD buf[WATCH_BUF_SIZE / sizeof(DWORD)];     /* DWORD-aligned records */
+    OVERLAPPED ov = {0};
+    ov.hEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+    if (!ov.hEvent) {
+        CloseHandle(dir);
+        return 0;
+    }
+
+    HANDLE waits[2] = { g_watch_stop, ov.hEvent };
+    BOOL issued = FALSE, pending = FALSE;
+    DWORD n;
+
+    for (;;) {
+        if (!issued) {
+            ResetEvent(ov.hEvent);
+            if (!ReadDirectoryChangesW(dir, buf, sizeof(buf), FALSE,
+                    FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE |
+                    FILE_NOTIFY_CHANGE_SIZE, NULL, &ov, NULL))
+                break;
+            issued = TRUE;
+        }
+
+        DWORD r = WaitForMultipleObjects(2, waits, FALSE, pending ? WATCH_DEBOUNCE : INFINITE);
+        if (r == WAIT_TIMEOUT) {
+            /* Our own save: reloading it could undo newer unsaved changes */
+            wchar_t path[MAX_PATH];
+            cfg_get_selected_properties_path(path, MAX_PATH);
+            pending = FALSE;
+            if (!cfgstore_is_own_write(path))
+                PostMessageW(g_notify_hwnd, g_notify_msg, 0, 0);
+            continue;
+        }
+        if (r != WAIT_OBJECT_0 + 1) break;     /* stop requested or wait failed */
+
+        issued = FALSE;
+        if (!GetOverlappedResult(dir, &ov, &n, FALSE)) break;
+        /* n == 0: more changes than the buffer holds; assume ours is one */
+        if (n == 0 || batch_names_active_profile((const BYTE *)buf))
+            pending = TRUE;
+    }
+
+    if (issued) {
+        CancelIo(dir);
+        GetOverlappedResult(dir, &ov, &n, TRUE);
+    }
+    CloseHandle(ov.hEvent);
+    CloseHandle(dir);
+    return 0;
+}
+
+BOOL cfgwatch_start(HWND hwnd, UINT msg) {
+    HANDLE dir = CreateFileW(cfg_get_user_dir(), FILE_LIST_DIRECTORY,
+                             FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+                             OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+    if (dir == INVALID_HANDLE_VALUE) return FALSE;
+
+    g_watch_stop = CreateEventW(NULL, TRUE, FALSE, NULL);
+    if (!g_watch_stop) {
+        CloseHandle(dir);
+        return FALSE;
+    }
+
+    g_notify_hwnd = hwnd;
+    g_notify_msg = msg;
+    g_watch_thread = (HANDLE)_beginthreadex(NULL, 0, watch_proc, dir, 0, NULL);
+    if (!g_watch_thread) {
+        CloseHandle(dir);
+        CloseHandle(g_watch_stop);
+        g_watch_stop = NULL;
+        return FALSE;
+    }
+    return TRUE;
+}
+
+void cfgwatch_stop(void) {
+    if (!g_watch_thread) return;
+    SetEvent(g_watch_stop);
+    WaitForSingleObject(g_watch_thread, 2000);
+    CloseHandle(g_watch_thread);
+    g_watch_thread = NULL;
+    CloseHandle(g_watch_stop);
+    g_watch_stop = NULL;
+}
@@ -0,0 +1,20 @@
+/*
+ * Copyright (c) 2026 Li Ruijie
+ * Licensed under the GNU General Public License v3.0.
+ */
+
+#ifndef W10WHEEL_CFGWATCH_H
+#define W10WHEEL_CFGWATCH_H
+
+#include <windows.h>
+
+/*
+ * Watches the config directory on a background thread. Once the active
+ * profile's file has been quiet for a short debounce period after a
+ * change, msg is posted to hwnd; the reload itself runs there.
+ */
+
+BOOL cfgwatch_start(HWND hwnd, UINT msg);
+void cfgwatch_stop(void);
+
+#endif
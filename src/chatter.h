@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2026 Li Ruijie
+ * Licensed under the GNU General Public License v3.0.
+ */
+
+#ifndef W10WHEEL_CHATTER_H
+#define W10WHEEL_CHATTER_H
+
+#include <windows.h>
+
+/*
+ * Keyboard chatter filter. A physical down that follows the key's last
+ * release by less than its threshold is contact bounce: it and its
+ * matching up are dropped. Pure state machine over one key event at a
+ * time; the caller owns the state and the threading.
+ */
+
+typedef struct {
+    DWORD last_release[256];
+    DWORD open[8];          /* down passed, its up not yet */
+    DWORD chattered[8];     /* bounce down dropped, its up still to drop */
+} ChatterFilter;
+
+typedef enum {
+    CHATTER_PASS,
+    CHATTER_DROP,
+    CHATTER_BOUNCE,         /* dropped, and a new bounce to count */
+} ChatterResult;
+
+/* ms: the key's threshold, 0 = filter off for this event */
+static inline ChatterResult chatter_filter(ChatterFilter *f, int vk, BOOL up,
+                                           DWORD time, int ms) {
+    vk &= 0xFF;
+    DWORD bit = 1u << (vk & 31);
+    DWORD *open = &f->open[vk >> 5];
+    DWORD *chattered = &f->chattered[vk >> 5];
+
+    if (up) {
+        f->last_release[vk] = time;
+        if (*chattered & bit) {
+            *chattered &= ~bit;
+            return CHATTER_DROP;
+        }
+        *open &= ~bit;
+        return CHATTER_PASS;
+    }
+
+    /*
+     * Typematic repeats of an open key always pass, as does any down
+     * outside the bounce window; a held key's repeat after a bounce
+     * re-opens it, so its up must pass too.
+     */
+    if ((*open & bit) || ms == 0 || time - f->last_release[vk] >= (DWORD)ms) {
+        *chattered &= ~bit;
+        *open |= bit;
+        return CHATTER_PASS;
+    }
+    if (*chattered & bit) return CHATTER_DROP;
+    *chattered |= bit;
+    return CHATTER_BOUNCE;
+}
+
+#endif
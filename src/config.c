@@ -4,9 +4,15 @@
  */
 
 #include "config.h"
+#include "cfgschema.h"
 #include "util.h"
 #include "cursor.h"
 #include "rawinput.h"
+#include "vkcode.h"
+#include "cfgstore.h"
+#include "cfgsnap.h"
+#include "iniparse.h"
+#include "krepeat.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -22,72 +28,104 @@ static _locale_t get_c_locale(void) {
 
 /* ========== Global config state ========== */
 
-static volatile Trigger  g_trigger        = TRIGGER_LR;
-static volatile int      g_poll_timeout   = 200;
-static volatile int      g_drag_threshold = 0;
-static volatile BOOL     g_keyboard_hook  = FALSE;
-static volatile int      g_target_vk_code = 0x1D; /* VK_NONCONVERT */
-static volatile BOOL     g_send_middle_click = FALSE;
-static volatile BOOL     g_pass_mode      = FALSE;
+/*
+ * Settings live in immutable snapshots. Writers fill a draft under
+ * g_write_cs and publish it with one pointer swap (cfg_begin_update /
+ * cfg_end_update), so a reload is never observed half applied. Its side
+ * effects run once, after the writer lock is released. Threads other
+ * than the UI thread pin the current snapshot around their reads
+ * (cfg_read_begin/end); publication and reclamation are in cfgsnap.c.
+ *
+ * publish() skips unchanged drafts with memcmp. That is sound because
+ * every snapshot descends from the zeroed boot snapshot through memcpy
+ * and per-field stores, so padding bytes stay zero. Doubles compare by
+ * bit pattern: 0.0 against -0.0 at worst publishes an equal snapshot.
+ */
+typedef struct {
+    LONG     generation;    /* bumped per publish; lets derived state go stale */
+
+    /* Schema booleans and numbers (cfgschema.h), indexed by CFG_B_* / CFG_N_* */
+    BOOL     flag[CFG_BOOL_COUNT];
+    int      num[CFG_NUM_COUNT];
+
+    Trigger  trigger;
+    int      target_vk_code;
+    LONG     trigger_keys[8];   /* keyboard trigger keys: 256-bit set */
+    BYTE     key_opts[256];     /* KO_* options per trigger key */
+
+    /* Scroll */
+    wchar_t  raw_device_allow[256];
+
+    /* Acceleration */
+    AccelPreset accel_preset;
+    BOOL     custom_accel_disabled;
+    int      custom_threshold[64];
+    double   custom_multiplier[64];
+    int      custom_accel_count;
+
+    /* VH adjuster */
+    VHMethod vh_method;
+
+    /* Chatter filter: per-key overrides of debounceTime (-1 = none) */
+    SHORT    debounce_override[256];
+    BYTE     debounce_ms[256];  /* effective, ms */
+    BOOL     debounce_any;
+
+    Priority priority;
+} CfgSnapshot;
+
+#ifdef _MSC_VER
+#define TPKB_THREAD_LOCAL __declspec(thread)
+#else
+#define TPKB_THREAD_LOCAL __thread
+#endif
+
+/* Zeroed placeholder until cfg_init publishes the defaults; never freed */
+static CfgSnapshot       g_boot_snapshot;
+
+/* Writer side: one draft, nested updates publish at the outermost end */
+static CRITICAL_SECTION  g_write_cs;
+static CfgSnapshot       g_draft;
+static int               g_update_depth = 0;
+static BOOL              g_published_once = FALSE;
+
+/* Side effects: the snapshot they were last applied for (a private copy) */
+static CRITICAL_SECTION  g_effects_cs;
+static CfgSnapshot       g_applied;
+static BOOL              g_applied_once = FALSE;
+
+/* This thread's pin (cfg_read_begin/end) */
+static TPKB_THREAD_LOCAL int t_read_depth = 0;
+static TPKB_THREAD_LOCAL const CfgSnapshot *t_snapshot = NULL;
+
+static volatile LONG g_stray_read_reported = FALSE;
+
+/* Unpinned reads belong to the UI thread; any other thread is reported once */
+static const CfgSnapshot *snap(void) {
+    const CfgSnapshot *s = t_snapshot;
+    if (s) return s;
+    if (!cfgsnap_is_owner() && !InterlockedExchange(&g_stray_read_reported, TRUE))
+        OutputDebugStringW(L"tpkb: settings read unpinned off the UI thread\n");
+    return (const CfgSnapshot *)cfgsnap_current();
+}
+
+/*
+ * Runtime state word (RS_* bits). Pass mode, scroll mode and the drag
+ * flags live together so a hook event classifies itself with one load,
+ * and every transition is a single CAS: the hook and waiter threads can
+ * never observe a half-applied combination.
+ */
+static volatile LONG     g_state = 0;
 
 /* Scroll state */
-static volatile BOOL     g_scroll_mode      = FALSE;
-static volatile BOOL     g_scroll_starting  = FALSE;
-static volatile BOOL     g_scroll_released  = FALSE;
 static volatile DWORD    g_scroll_start_time = 0;
 static volatile int      g_scroll_start_x   = 0;
 static volatile int      g_scroll_start_y   = 0;
-static volatile int      g_scroll_locktime  = 200;
-static volatile BOOL     g_cursor_change    = TRUE;
-static volatile BOOL     g_reverse_scroll   = FALSE;
-static volatile BOOL     g_horizontal_scroll = TRUE;
-static volatile BOOL     g_dragged_lock     = FALSE;
-static volatile BOOL     g_swap_scroll      = FALSE;
-
-/* Real wheel */
-static volatile BOOL     g_real_wheel_mode = FALSE;
-static volatile int      g_wheel_delta     = 120;
-static volatile int      g_v_wheel_move    = 60;
-static volatile int      g_h_wheel_move    = 60;
-static volatile BOOL     g_quick_first     = FALSE;
-static volatile BOOL     g_quick_turn      = FALSE;
-
-/* Acceleration */
-static volatile BOOL     g_accel_table     = TRUE;
-static volatile AccelPreset g_accel_preset = ACCEL_PRESET_M5;
-static volatile BOOL     g_custom_accel    = FALSE;
-static volatile BOOL     g_custom_accel_disabled = TRUE;
-static int               g_custom_threshold[64];
-static double            g_custom_multiplier[64];
-static int               g_custom_accel_count = 0;
-
-/* VH adjuster */
-static volatile BOOL     g_vh_adjuster_mode = FALSE;
-static volatile VHMethod g_vh_method        = VH_SWITCHING;
-static volatile BOOL     g_first_prefer_vertical = TRUE;
-static volatile int      g_first_min_threshold   = 5;
-static volatile int      g_switching_threshold   = 50;
-
-/* Thresholds */
-static volatile int      g_vertical_threshold   = 0;
-static volatile int      g_horizontal_threshold = 75;
-
-/* Hook health check */
-static volatile int      g_hook_health_check = 0;
-
-/* Filter Keys */
-static volatile BOOL     g_filter_keys        = FALSE;
-static volatile BOOL     g_fk_lock            = FALSE;
-static volatile int      g_fk_acceptance_delay = 1000;
-static volatile int      g_fk_repeat_delay    = 1000;
-static volatile int      g_fk_repeat_rate     = 500;
-static volatile int      g_fk_bounce_time     = 0;
-static volatile int      g_kb_repeat_delay    = 1;
-static volatile int      g_kb_repeat_speed    = 31;
-
-static volatile Priority g_priority = PRIO_ABOVE_NORMAL;
-
-/* Properties profile */
+static volatile int      g_scroll_key_opts  = 0;  /* key that started the session */
+static volatile int      g_scroll_key       = 0;  /* its vk; 0 = mouse trigger */
+
+/* Properties profile: written on the UI thread under g_props_cs */
+static CRITICAL_SECTION  g_props_cs;
 static wchar_t           g_selected_props[256] = L"Default";
 static wchar_t           g_config_dir[MAX_PATH];
 
@@ -99,214 +137,363 @@ static CRITICAL_SECTION  g_scroll_cs;
 
 /* Callbacks */
 static VoidCallback      g_init_scroll_cb    = NULL;
+static VoidCallback      g_exit_scroll_cb    = NULL;
 static VoidCallback      g_change_trigger_cb = NULL;
 static VoidCallback      g_init_state_meh_cb = NULL;
 static VoidCallback      g_init_state_keh_cb = NULL;
+static VoidCallback      g_mouse_demand_cb   = NULL;
+static VoidCallback      g_prepare_scroll_cb = NULL;
 
-/* ========== Properties file I/O (simple key=value) ========== */
+/* Reads and file operations wait this long (ms) for a pending save */
+#define STORE_WAIT 2000
 
-#define MAX_PROPS 128
+/* Longest INI key and value, in characters */
 #define MAX_KEY_LEN 64
 #define MAX_VAL_LEN 1024
 
+/* ========== Settings schema (cfgschema.h) ========== */
+
+typedef enum { CFG_TYPE_STRING, CFG_TYPE_BOOL, CFG_TYPE_NUMBER } CfgType;
+
 typedef struct {
-    wchar_t key[MAX_KEY_LEN];
-    wchar_t value[MAX_VAL_LEN];
-} PropEntry;
+    const wchar_t *section;
+    const wchar_t *ini_key;
+    const wchar_t *name;        /* internal key */
+    BYTE           type;        /* CfgType */
+    BYTE           slot;        /* CFG_B_* or CFG_N_*; unused for strings */
+    int            low, up, def;
+} CfgEntry;
+
+#define SCHEMA_S(id, sec, key, name) \
+    { sec, key, name, CFG_TYPE_STRING, 0, 0, 0, 0 },
+#define SCHEMA_B(id, sec, key, name, def) \
+    { sec, key, name, CFG_TYPE_BOOL, CFG_B_##id, FALSE, TRUE, def },
+#define SCHEMA_N(id, sec, key, name, lo, up, def) \
+    { sec, key, name, CFG_TYPE_NUMBER, CFG_N_##id, lo, up, def },
+
+static const CfgEntry g_schema[] = {
+    CFG_SCHEMA(SCHEMA_S, SCHEMA_B, SCHEMA_N)
+};
+#define SCHEMA_COUNT ((int)(sizeof(g_schema) / sizeof(g_schema[0])))
+
+#undef SCHEMA_S
+#undef SCHEMA_B
+#undef SCHEMA_N
+
+static const wchar_t *INI_SECTIONS[] = {
+    L"General", L"Scroll", L"Acceleration", L"Real Wheel", L"VH Adjuster", L"Keyboard"
+};
+#define INI_SECTION_COUNT (sizeof(INI_SECTIONS) / sizeof(INI_SECTIONS[0]))
 
-static PropEntry g_props[MAX_PROPS];
-static int       g_prop_count = 0;
+/*
+ * Name lookups go through two perfect hash tables (internal name, and
+ * section + INI key), generated from the schema at init: seeds are tried
+ * until every entry lands in its own slot, so a lookup is one hash and
+ * one compare.
+ */
+#define SCHEMA_HASH_SIZE  256   /* power of two */
+#define SCHEMA_SEED_TRIES 65536
+
+static BYTE  g_name_slots[SCHEMA_HASH_SIZE];   /* schema index + 1; 0 = empty */
+static BYTE  g_ini_slots[SCHEMA_HASH_SIZE];
+static DWORD g_name_seed;
+static DWORD g_ini_seed;
+
+static DWORD hash_str(DWORD h, const wchar_t *s) {
+    while (*s) {
+        h ^= (WORD)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
 
-static int prop_find(const wchar_t *key) {
-    for (int i = 0; i < g_prop_count; i++)
-        if (wcscmp(g_props[i].key, key) == 0) return i;
-    return -1;
+static DWORD name_hash(DWORD seed, const wchar_t *name) {
+    DWORD h = hash_str(seed, name);
+    return h ^ (h >> 16);
 }
 
-static const wchar_t *prop_get(const wchar_t *key) {
-    int i = prop_find(key);
-    return i >= 0 ? g_props[i].value : NULL;
+static DWORD ini_hash(DWORD seed, const wchar_t *section, const wchar_t *ini_key) {
+    DWORD h = hash_str(hash_str(seed, section) ^ L']', ini_key);
+    return h ^ (h >> 16);
 }
 
-static void prop_set(const wchar_t *key, const wchar_t *value) {
-    int i = prop_find(key);
-    if (i >= 0) {
-        wcsncpy(g_props[i].value, value, MAX_VAL_LEN - 1);
-        g_props[i].value[MAX_VAL_LEN - 1] = L'\0';
-    } else if (g_prop_count < MAX_PROPS) {
-        wcsncpy(g_props[g_prop_count].key, key, MAX_KEY_LEN - 1);
-        g_props[g_prop_count].key[MAX_KEY_LEN - 1] = L'\0';
-        wcsncpy(g_props[g_prop_count].value, value, MAX_VAL_LEN - 1);
-        g_props[g_prop_count].value[MAX_VAL_LEN - 1] = L'\0';
-        g_prop_count++;
+static DWORD entry_hash(DWORD seed, int i, BOOL ini) {
+    return ini ? ini_hash(seed, g_schema[i].section, g_schema[i].ini_key)
+               : name_hash(seed, g_schema[i].name);
+}
+
+static void schema_hash_build(BYTE *slots, DWORD *seed, BOOL ini) {
+    DWORD sd = 2166136261u;
+    for (int t = 0; t < SCHEMA_SEED_TRIES; t++, sd += 0x9E3779B9u) {
+        int i;
+        memset(slots, 0, SCHEMA_HASH_SIZE);
+        for (i = 0; i < SCHEMA_COUNT; i++) {
+            BYTE *slot = &slots[entry_hash(sd, i, ini) & (SCHEMA_HASH_SIZE - 1)];
+            if (*slot) break;
+            *slot = (BYTE)(i + 1);
+        }
+        if (i == SCHEMA_COUNT) {
+            *seed = sd;
+            return;
+        }
     }
+    /* Duplicate key in the schema: lookups find nothing */
+    memset(slots, 0, SCHEMA_HASH_SIZE);
 }
 
-static void prop_clear(void) {
-    g_prop_count = 0;
+static const CfgEntry *schema_find(const wchar_t *name) {
+    int i = g_name_slots[name_hash(g_name_seed, name) & (SCHEMA_HASH_SIZE - 1)];
+    if (i == 0 || wcscmp(g_schema[i - 1].name, name) != 0) return NULL;
+    return &g_schema[i - 1];
 }
 
-/* ========== INI mapping (section + ini_key -> internal_key) ========== */
+/*
+ * The loader looks keys up straight from the file bytes. Schema keys are
+ * ASCII, so hashing bytes gives the same value as hashing the wide key;
+ * anything non-ASCII simply fails the compare.
+ */
+static DWORD hash_span(DWORD h, const char *s, int len) {
+    for (int i = 0; i < len; i++) {
+        h ^= (BYTE)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
 
-typedef struct {
-    const wchar_t *section;
-    const wchar_t *ini_key;
-    const wchar_t *internal_key;
-} IniMapping;
-
-static const IniMapping g_ini_map[] = {
-    /* General */
-    { L"General", L"trigger",               L"firstTrigger" },
-    { L"General", L"send_middle_click",      L"sendMiddleClick" },
-    { L"General", L"dragged_lock",           L"draggedLock" },
-    { L"General", L"keyboard_hook",          L"keyboardHook" },
-    { L"General", L"vk_code",               L"targetVKCode" },
-    { L"General", L"priority",              L"processPriority" },
-    { L"General", L"health_check_interval",  L"hookHealthCheck" },
-    /* Scroll */
-    { L"Scroll", L"cursor_change",          L"cursorChange" },
-    { L"Scroll", L"horizontal_scroll",      L"horizontalScroll" },
-    { L"Scroll", L"reverse_scroll",         L"reverseScroll" },
-    { L"Scroll", L"swap_scroll",            L"swapScroll" },
-    { L"Scroll", L"poll_timeout",           L"pollTimeout" },
-    { L"Scroll", L"scroll_lock_time",       L"scrollLocktime" },
-    { L"Scroll", L"vertical_threshold",     L"verticalThreshold" },
-    { L"Scroll", L"horizontal_threshold",   L"horizontalThreshold" },
-    { L"Scroll", L"drag_threshold",         L"dragThreshold" },
-    /* Acceleration */
-    { L"Acceleration", L"accel_table",             L"accelTable" },
-    { L"Acceleration", L"multiplier",              L"accelMultiplier" },
-    { L"Acceleration", L"custom_accel_table",      L"customAccelTable" },
-    { L"Acceleration", L"custom_accel_threshold",  L"customAccelThreshold" },
-    { L"Acceleration", L"custom_accel_multiplier", L"customAccelMultiplier" },
-    /* Real Wheel */
-    { L"Real Wheel", L"real_wheel_mode",    L"realWheelMode" },
-    { L"Real Wheel", L"wheel_delta",        L"wheelDelta" },
-    { L"Real Wheel", L"vertical_speed",     L"vWheelMove" },
-    { L"Real Wheel", L"horizontal_speed",   L"hWheelMove" },
-    { L"Real Wheel", L"quick_first",        L"quickFirst" },
-    { L"Real Wheel", L"quick_turn",         L"quickTurn" },
-    /* VH Adjuster */
-    { L"VH Adjuster", L"vh_adjuster_mode",   L"vhAdjusterMode" },
-    { L"VH Adjuster", L"method",             L"vhAdjusterMethod" },
-    { L"VH Adjuster", L"prefer_vertical",    L"firstPreferVertical" },
-    { L"VH Adjuster", L"min_threshold",      L"firstMinThreshold" },
-    { L"VH Adjuster", L"switching_threshold", L"switchingThreshold" },
-    /* Keyboard */
-    { L"Keyboard", L"character_repeat_delay",        L"kbRepeatDelay" },
-    { L"Keyboard", L"character_repeat_speed",        L"kbRepeatSpeed" },
-    { L"Keyboard", L"filter_keys",                   L"filterKeys" },
-    { L"Keyboard", L"filter_keys_lock",              L"fkLock" },
-    { L"Keyboard", L"filter_keys_acceptance_delay",  L"fkAcceptanceDelay" },
-    { L"Keyboard", L"filter_keys_repeat_delay",      L"fkRepeatDelay" },
-    { L"Keyboard", L"filter_keys_repeat_rate",       L"fkRepeatRate" },
-    { L"Keyboard", L"filter_keys_bounce_time",       L"fkBounceTime" },
-};
-#define INI_MAP_COUNT (sizeof(g_ini_map) / sizeof(g_ini_map[0]))
+static BOOL span_equals(const wchar_t *w, const char *s, int len) {
+    for (int i = 0; i < len; i++)
+        if (w[i] == L'\0' || w[i] != (BYTE)s[i]) return FALSE;
+    return w[len] == L'\0';
+}
 
-static const wchar_t *INI_SECTIONS[] = {
-    L"General", L"Scroll", L"Acceleration", L"Real Wheel", L"VH Adjuster", L"Keyboard"
-};
-#define INI_SECTION_COUNT (sizeof(INI_SECTIONS) / sizeof(INI_SECTIONS[0]))
+static const CfgEntry *ini_find(const char *section, int section_len,
+                                const char *ini_key, int key_len) {
+    DWORD h = hash_span(hash_span(g_ini_seed, section, section_len) ^ L']', ini_key, key_len);
+    int i = g_ini_slots[(h ^ (h >> 16)) & (SCHEMA_HASH_SIZE - 1)];
+    if (i == 0) return NULL;
+    const CfgEntry *e = &g_schema[i - 1];
+    if (!span_equals(e->section, section, section_len) ||
+        !span_equals(e->ini_key, ini_key, key_len))
+        return NULL;
+    return e;
+}
 
-static const wchar_t *ini_to_internal(const wchar_t *section, const wchar_t *ini_key) {
-    for (int i = 0; i < (int)INI_MAP_COUNT; i++) {
-        if (wcscmp(g_ini_map[i].section, section) == 0 &&
-            wcscmp(g_ini_map[i].ini_key, ini_key) == 0)
-            return g_ini_map[i].internal_key;
+/* ========== Properties store (interned UTF-8) ========== */
+
+/*
+ * Properties are keyed by schema entry, so the store is one arena offset
+ * per entry. Values are interned UTF-8 in an arena ("True", "500" and
+ * friends are stored once), found through an open-addressing index.
+ * Replaced values stay in the arena until it or the index fills; then
+ * the live ones are compacted into a fresh arena sized for them plus
+ * room to grow, so a value is never dropped for lack of space.
+ */
+#define PROP_ARENA_MIN    8192
+#define PROP_INTERN_SIZE  256   /* power of two */
+#define PROP_INTERN_MAX   (PROP_INTERN_SIZE / 2)   /* > SCHEMA_COUNT live values */
+
+static char *g_prop_arena = NULL;
+static int   g_prop_arena_size = 0;
+static int   g_prop_arena_used = 0;
+static int   g_prop_intern[PROP_INTERN_SIZE];   /* arena offset + 1; 0 = empty */
+static int   g_prop_intern_count = 0;
+static int   g_prop_value[SCHEMA_COUNT];        /* arena offset + 1; 0 = unset */
+
+static DWORD hash_utf8(const char *s, int len) {
+    DWORD h = 2166136261u;
+    for (int i = 0; i < len; i++) {
+        h ^= (BYTE)s[i];
+        h *= 16777619u;
     }
-    return NULL;
+    return h;
 }
 
-static void prop_load(const wchar_t *path) {
-    FILE *f = _wfopen(path, L"r");
-    if (!f) return;
-
-    char line[2048];
-    wchar_t section[64] = L"";
-
-    while (fgets(line, sizeof(line), f)) {
-        /* Strip newline */
-        char *nl = strchr(line, '\n');
-        if (nl) *nl = '\0';
-        nl = strchr(line, '\r');
-        if (nl) *nl = '\0';
-
-        /* Skip leading whitespace */
-        char *p = line;
-        while (*p == ' ' || *p == '\t') p++;
-        if (*p == '#' || *p == ';' || *p == '\0') continue;
-
-        /* Section header */
-        if (*p == '[') {
-            char *end = strchr(p, ']');
-            if (end) {
-                int len = (int)(end - p - 1);
-                if (len > 0 && len < 64)
-                    MultiByteToWideChar(CP_UTF8, 0, p + 1, len, section, 63);
-                section[len] = L'\0';
-            }
-            continue;
+/* Arena offset + 1 of the string, added if new; 0 when full */
+static int prop_intern(const char *s, int len) {
+    for (DWORD i = hash_utf8(s, len);; i++) {
+        int *slot = &g_prop_intern[i & (PROP_INTERN_SIZE - 1)];
+        if (*slot == 0) {
+            if (g_prop_intern_count >= PROP_INTERN_MAX ||
+                g_prop_arena_used + len + 1 > g_prop_arena_size)
+                return 0;
+            memcpy(g_prop_arena + g_prop_arena_used, s, len);
+            g_prop_arena[g_prop_arena_used + len] = '\0';
+            *slot = g_prop_arena_used + 1;
+            g_prop_arena_used += len + 1;
+            g_prop_intern_count++;
+            return *slot;
         }
+        const char *t = g_prop_arena + *slot - 1;
+        if (strncmp(t, s, len) == 0 && t[len] == '\0')
+            return *slot;
+    }
+}
+
+static void prop_reset_arena(void) {
+    g_prop_arena_used = 0;
+    g_prop_intern_count = 0;
+    memset(g_prop_intern, 0, sizeof(g_prop_intern));
+}
+
+/*
+ * Re-interns only the values still referenced into a new arena with room
+ * for need more bytes. On allocation failure the old arena is untouched.
+ */
+static BOOL prop_compact(int need) {
+    int live = 0;
+    for (int i = 0; i < SCHEMA_COUNT; i++)
+        if (g_prop_value[i]) live += (int)strlen(g_prop_arena + g_prop_value[i] - 1) + 1;
+    int size = 2 * (live + need);
+    if (size < PROP_ARENA_MIN) size = PROP_ARENA_MIN;
+
+    char *nw = (char *)malloc(size);
+    if (!nw) return FALSE;
+    char *old = g_prop_arena;
+    g_prop_arena = nw;
+    g_prop_arena_size = size;
+    prop_reset_arena();
+    for (int i = 0; i < SCHEMA_COUNT; i++) {
+        if (!g_prop_value[i]) continue;
+        const char *v = old + g_prop_value[i] - 1;
+        g_prop_value[i] = prop_intern(v, (int)strlen(v));
+    }
+    free(old);
+    return TRUE;
+}
+
+/* FALSE only when out of memory; the entry then keeps its old value */
+static BOOL prop_set_utf8(const CfgEntry *e, const char *value, int len) {
+    int off = prop_intern(value, len);
+    if (!off) {
+        if (prop_compact(len + 1))
+            off = prop_intern(value, len);
+        if (!off) {
+            wchar_t msg[128];
+            _snwprintf(msg, 128, L"tpkb: out of memory, %s keeps its old value\n", e->name);
+            OutputDebugStringW(msg);
+            return FALSE;
+        }
+    }
+    g_prop_value[e - g_schema] = off;
+    return TRUE;
+}
+
+static const char *prop_get_utf8(const CfgEntry *e) {
+    int off = g_prop_value[e - g_schema];
+    return off ? g_prop_arena + off - 1 : NULL;
+}
+
+/* Copies the value into buf; NULL when unset */
+static const wchar_t *prop_get(const wchar_t *key, wchar_t *buf, int bufsize) {
+    const CfgEntry *e = schema_find(key);
+    const char *v = e ? prop_get_utf8(e) : NULL;
+    if (!v) return NULL;
+    if (!MultiByteToWideChar(CP_UTF8, 0, v, -1, buf, bufsize))
+        buf[0] = L'\0';
+    buf[bufsize - 1] = L'\0';
+    return buf;
+}
 
-        /* Need a current section */
-        if (section[0] == L'\0') continue;
+static BOOL prop_has(const wchar_t *key) {
+    const CfgEntry *e = schema_find(key);
+    return e && prop_get_utf8(e);
+}
 
-        /* Split on '=' */
-        char *eq = strchr(p, '=');
-        if (!eq) continue;
-        *eq = '\0';
+static void prop_set(const wchar_t *key, const wchar_t *value) {
+    const CfgEntry *e = schema_find(key);
+    if (!e) return;
+    char buf[MAX_VAL_LEN * 3];
+    int wlen = (int)wcslen(value);
+    if (wlen > MAX_VAL_LEN - 1) wlen = MAX_VAL_LEN - 1;
+    int len = wlen ? WideCharToMultiByte(CP_UTF8, 0, value, wlen, buf, sizeof(buf), NULL, NULL) : 0;
+    prop_set_utf8(e, buf, len);
+}
 
-        /* Trim key */
-        char *k = p; while (*k == ' ') k++;
-        size_t klen = strlen(k);
-        if (klen > 0) { char *ke = k + klen - 1; while (ke > k && *ke == ' ') *ke-- = '\0'; }
+static void prop_clear(void) {
+    memset(g_prop_value, 0, sizeof(g_prop_value));
+    prop_reset_arena();
+}
 
-        /* Trim value */
-        char *v = eq + 1; while (*v == ' ') v++;
-        size_t vlen = strlen(v);
-        if (vlen > 0) { char *ve = v + vlen - 1; while (ve > v && *ve == ' ') *ve-- = '\0'; }
+/* ========== Properties file I/O (simple key=value) ========== */
 
-        if (!*k || !*v) continue;
+#define PROP_FILE_MAX (1024 * 1024)
 
-        /* Convert to wide and translate */
-        wchar_t wkey[MAX_KEY_LEN], wval[MAX_VAL_LEN];
-        MultiByteToWideChar(CP_UTF8, 0, k, -1, wkey, MAX_KEY_LEN);
-        MultiByteToWideChar(CP_UTF8, 0, v, -1, wval, MAX_VAL_LEN);
+/* Known keys only; values capped at MAX_VAL_LEN - 1 bytes */
+static void prop_parse_key(void *ctx, const char *sec, int sec_len,
+                           const char *key, int key_len,
+                           const char *val, int val_len) {
+    (void)ctx;
+    if (key_len >= MAX_KEY_LEN) return;
+    const CfgEntry *e = ini_find(sec, sec_len, key, key_len);
+    if (e) prop_set_utf8(e, val, ini_utf8_prefix(val, val_len, MAX_VAL_LEN - 1));
+}
 
-        const wchar_t *internal = ini_to_internal(section, wkey);
-        if (internal)
-            prop_set(internal, wval);
+static void prop_load(const wchar_t *path) {
+    HANDLE file = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) return;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0 || size.QuadPart > PROP_FILE_MAX) {
+        CloseHandle(file);
+        return;
     }
-    fclose(f);
+
+    HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (!mapping) return;
+
+    const char *view = (const char *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!view) return;
+
+    ini_parse(view, view + size.LowPart, prop_parse_key, NULL);
+    UnmapViewOfFile(view);
 }
 
-static void prop_store(const wchar_t *path) {
-    wchar_t tmp[MAX_PATH + 8];
-    _snwprintf(tmp, MAX_PATH + 8, L"%s.tmp", path);
+static int put_bytes(char *buf, int cap, int len, const char *s, int n) {
+    if (buf && len + n <= cap) memcpy(buf + len, s, n);
+    return len + n;
+}
 
-    FILE *f = _wfopen(tmp, L"w");
-    if (!f) return;
+static int put_wide(char *buf, int cap, int len, const wchar_t *w) {
+    char tmp[MAX_KEY_LEN * 3];
+    int n = WideCharToMultiByte(CP_UTF8, 0, w, -1, tmp, sizeof(tmp), NULL, NULL);
+    return n > 1 ? put_bytes(buf, cap, len, tmp, n - 1) : len;
+}
 
+/* INI text (UTF-8, CRLF); returns the full length, writing only what fits */
+static int prop_format(char *buf, int cap) {
+    int len = 0;
     for (int s = 0; s < (int)INI_SECTION_COUNT; s++) {
         BOOL header_written = FALSE;
-        for (int i = 0; i < (int)INI_MAP_COUNT; i++) {
-            if (wcscmp(g_ini_map[i].section, INI_SECTIONS[s]) != 0) continue;
-            const wchar_t *v = prop_get(g_ini_map[i].internal_key);
+        for (int i = 0; i < SCHEMA_COUNT; i++) {
+            if (wcscmp(g_schema[i].section, INI_SECTIONS[s]) != 0) continue;
+            const char *v = prop_get_utf8(&g_schema[i]);
             if (!v) continue;
             if (!header_written) {
-                if (s > 0) fprintf(f, "\n");
-                fprintf(f, "[%ls]\n", INI_SECTIONS[s]);
+                if (s > 0) len = put_bytes(buf, cap, len, "\r\n", 2);
+                len = put_bytes(buf, cap, len, "[", 1);
+                len = put_wide(buf, cap, len, INI_SECTIONS[s]);
+                len = put_bytes(buf, cap, len, "]\r\n", 3);
                 header_written = TRUE;
             }
-            fprintf(f, "%ls=%ls\n", g_ini_map[i].ini_key, v);
+            len = put_wide(buf, cap, len, g_schema[i].ini_key);
+            len = put_bytes(buf, cap, len, "=", 1);
+            len = put_bytes(buf, cap, len, v, (int)strlen(v));
+            len = put_bytes(buf, cap, len, "\r\n", 2);
         }
     }
+    return len;
+}
 
-    fclose(f);
-
-    if (!MoveFileExW(tmp, path, MOVEFILE_REPLACE_EXISTING))
-        DeleteFileW(tmp);
+/* Formats in memory; the background writer puts it on disk */
+static void prop_store(const wchar_t *path) {
+    int len = prop_format(NULL, 0);
+    char *data = (char *)malloc(len > 0 ? len : 1);
+    if (!data) return;
+    prop_format(data, len);
+    cfgstore_write(path, data, len);
 }
 
 /* ========== Path helpers ========== */
@@ -329,12 +516,14 @@ void cfg_properties_copy(const wchar_t *src, const wchar_t *dest) {
     wchar_t sp[MAX_PATH], dp[MAX_PATH];
     cfg_get_properties_path(src, sp, MAX_PATH);
     cfg_get_properties_path(dest, dp, MAX_PATH);
+    cfgstore_flush(STORE_WAIT);
     CopyFileW(sp, dp, TRUE);
 }
 
 void cfg_properties_delete(const wchar_t *name) {
     wchar_t path[MAX_PATH];
     cfg_get_properties_path(name, path, MAX_PATH);
+    cfgstore_flush(STORE_WAIT);  /* a pending write would recreate it */
     DeleteFileW(path);
 }
 
@@ -374,10 +563,23 @@ const wchar_t *cfg_get_user_dir(void) { return g_config_dir; }
 
 /* ========== Initialization ========== */
 
+static void cfg_set_defaults(void);
+
 void cfg_init(void) {
     InitializeCriticalSection(&g_scroll_cs);
+    InitializeCriticalSection(&g_props_cs);
+    InitializeCriticalSection(&g_write_cs);
+    InitializeCriticalSection(&g_effects_cs);
+    cfgsnap_init(&g_boot_snapshot);
+    vk_table_init();
+    schema_hash_build(g_name_slots, &g_name_seed, FALSE);
+    schema_hash_build(g_ini_slots, &g_ini_seed, TRUE);
     memset(&g_last_flags, 0, sizeof(g_last_flags));
 
+    cfg_begin_update();
+    cfg_set_defaults();
+    cfg_end_update();
+
     /* Build config dir path and ensure it exists */
     wchar_t home[MAX_PATH];
     ExpandEnvironmentStringsW(L"%USERPROFILE%", home, MAX_PATH);
@@ -391,30 +593,147 @@ void cfg_init(void) {
 /* ========== Callback setters ========== */
 
 void cfg_set_init_scroll_cb(VoidCallback f) { g_init_scroll_cb = f; }
+void cfg_set_exit_scroll_cb(VoidCallback f) { g_exit_scroll_cb = f; }
 void cfg_set_change_trigger_cb(VoidCallback f) { g_change_trigger_cb = f; }
 void cfg_set_init_state_meh_cb(VoidCallback f) { g_init_state_meh_cb = f; }
 void cfg_set_init_state_keh_cb(VoidCallback f) { g_init_state_keh_cb = f; }
+void cfg_set_mouse_demand_cb(VoidCallback f) { g_mouse_demand_cb = f; }
+void cfg_set_prepare_scroll_cb(VoidCallback f) { g_prepare_scroll_cb = f; }
+
+LONG cfg_get_generation(void) { return snap()->generation; }
+
+static void notify_mouse_demand(void) {
+    if (g_mouse_demand_cb) g_mouse_demand_cb();
+}
+
+/* ========== Snapshot publication ========== */
+
+/* Pins the current snapshot for this thread until the matching end */
+void cfg_read_begin(void) {
+    if (t_read_depth++ > 0) return;
+    t_snapshot = (const CfgSnapshot *)cfgsnap_pin();
+}
+
+void cfg_read_end(void) {
+    if (--t_read_depth > 0) return;
+    t_snapshot = NULL;
+    cfgsnap_unpin();
+}
+
+/*
+ * Side effects run once per publish, only for what changed. The first
+ * publish applies them all.
+ */
+static void apply_side_effects(const CfgSnapshot *old, const CfgSnapshot *nw) {
+    BOOL all = old == NULL;
+    if (all || old->priority != nw->priority)
+        util_set_priority(nw->priority);
+    if (all || old->flag[CFG_B_RAW_INPUT_PERSISTENT] != nw->flag[CFG_B_RAW_INPUT_PERSISTENT])
+        rawinput_set_persistent(nw->flag[CFG_B_RAW_INPUT_PERSISTENT]);
+    if (all || wcscmp(old->raw_device_allow, nw->raw_device_allow) != 0)
+        rawinput_set_device_allow(nw->raw_device_allow);
+    if (!all && old->flag[CFG_B_SW_REPEAT] && !nw->flag[CFG_B_SW_REPEAT])
+        krepeat_cancel();
+    if (all || old->trigger != nw->trigger) {
+        if (g_change_trigger_cb) g_change_trigger_cb();
+        notify_mouse_demand();
+    }
+}
+
+/* TRUE if a new snapshot went out */
+static BOOL publish(void) {
+    const CfgSnapshot *old = (const CfgSnapshot *)cfgsnap_current();
+    /* Nothing changed (e.g. a reload of an unmodified file): keep it */
+    g_draft.generation = old->generation;
+    if (g_published_once && memcmp(&g_draft, old, sizeof(CfgSnapshot)) == 0)
+        return FALSE;
+
+    CfgSnapshot *nw = (CfgSnapshot *)cfgsnap_alloc(sizeof(CfgSnapshot));
+    if (!nw) return FALSE;
+    g_draft.generation = old->generation + 1;
+    memcpy(nw, &g_draft, sizeof(CfgSnapshot));
+
+    cfgsnap_publish(nw);
+    g_published_once = TRUE;
+    return TRUE;
+}
+
+/*
+ * Runs outside g_write_cs: the callbacks take the hook, raw input and
+ * scroll locks and may post to other threads. Racing publishers apply in
+ * generation order; one that finds a newer state already applied skips.
+ */
+static void run_side_effects(void) {
+    EnterCriticalSection(&g_effects_cs);
+    cfg_read_begin();
+    const CfgSnapshot *nw = snap();
+    if (!g_applied_once || nw->generation > g_applied.generation) {
+        apply_side_effects(g_applied_once ? &g_applied : NULL, nw);
+        memcpy(&g_applied, nw, sizeof(CfgSnapshot));
+        g_applied_once = TRUE;
+    }
+    cfg_read_end();
+    LeaveCriticalSection(&g_effects_cs);
+}
+
+/* Updates nest; the outermost end publishes one snapshot */
+void cfg_begin_update(void) {
+    EnterCriticalSection(&g_write_cs);
+    if (g_update_depth++ == 0)
+        memcpy(&g_draft, cfgsnap_current(), sizeof(CfgSnapshot));
+}
+
+void cfg_end_update(void) {
+    BOOL published = --g_update_depth == 0 && publish();
+    LeaveCriticalSection(&g_write_cs);
+    if (published) run_side_effects();
+}
 
 /* ========== Trigger getters/setters ========== */
 
-Trigger cfg_get_trigger(void) { return g_trigger; }
+Trigger cfg_get_trigger(void) { return snap()->trigger; }
 
+/* The change callback and mouse demand update run when the update publishes */
 void cfg_set_trigger(Trigger t) {
-    g_trigger = t;
-    if (g_change_trigger_cb) g_change_trigger_cb();
+    cfg_begin_update();
+    g_draft.trigger = t;
+    cfg_end_update();
 }
 
 void cfg_set_trigger_name(const wchar_t *name) {
     cfg_set_trigger(trigger_from_name(name));
 }
 
-int  cfg_get_poll_timeout(void) { return g_poll_timeout; }
-int  cfg_get_drag_threshold(void) { return g_drag_threshold; }
-BOOL cfg_is_keyboard_hook(void) { return g_keyboard_hook; }
-int  cfg_get_target_vk_code(void) { return g_target_vk_code; }
-BOOL cfg_is_send_middle_click(void) { return g_send_middle_click; }
+int  cfg_get_poll_timeout(void) { return snap()->num[CFG_N_POLL_TIMEOUT]; }
+int  cfg_get_drag_threshold(void) { return snap()->num[CFG_N_DRAG_THRESHOLD]; }
+BOOL cfg_is_keyboard_hook(void) { return snap()->flag[CFG_B_KEYBOARD_HOOK]; }
+BOOL cfg_is_keyboard_hook_needed(void) {
+    const CfgSnapshot *s = snap();
+    return s->flag[CFG_B_KEYBOARD_HOOK] || s->flag[CFG_B_SW_REPEAT] || s->debounce_any;
+}
+BOOL cfg_is_sw_repeat(void) { return snap()->flag[CFG_B_SW_REPEAT]; }
+
+static const BYTE SW_REPEAT_DELAY_ID[KR_CLASS_COUNT] = {
+    CFG_N_SW_REPEAT_DELAY, CFG_N_SW_REPEAT_NAV_DELAY, CFG_N_SW_REPEAT_EDIT_DELAY
+};
+static const BYTE SW_REPEAT_INTERVAL_ID[KR_CLASS_COUNT] = {
+    CFG_N_SW_REPEAT_INTERVAL, CFG_N_SW_REPEAT_NAV_INTERVAL, CFG_N_SW_REPEAT_EDIT_INTERVAL
+};
+
+int cfg_get_sw_repeat_delay(int cls) {
+    return snap()->num[SW_REPEAT_DELAY_ID[(unsigned)cls < KR_CLASS_COUNT ? cls : KR_CLASS_DEFAULT]];
+}
+
+int cfg_get_sw_repeat_interval(int cls) {
+    return snap()->num[SW_REPEAT_INTERVAL_ID[(unsigned)cls < KR_CLASS_COUNT ? cls : KR_CLASS_DEFAULT]];
+}
+
+BOOL cfg_is_debounce(void) { return snap()->debounce_any; }
+int  cfg_get_debounce_ms(int vk) { return snap()->debounce_ms[vk & 0xFF]; }
+int  cfg_get_target_vk_code(void) { return snap()->target_vk_code; }
+BOOL cfg_is_send_middle_click(void) { return snap()->flag[CFG_B_SEND_MIDDLE_CLICK]; }
 
-BOOL cfg_is_trigger(Trigger t) { return g_trigger == t; }
+BOOL cfg_is_trigger(Trigger t) { return snap()->trigger == t; }
 BOOL cfg_is_trigger_event(MouseEventType t) { return cfg_is_trigger(me_get_trigger(t)); }
 
 BOOL cfg_is_drag_trigger_event(MouseEventType t) {
@@ -422,43 +741,106 @@ BOOL cfg_is_drag_trigger_event(MouseEventType t) {
 }
 
 BOOL cfg_is_lr_trigger(void)     { return cfg_is_trigger(TRIGGER_LR); }
-BOOL cfg_is_single_trigger(void) { return trigger_is_single(g_trigger); }
-BOOL cfg_is_double_trigger(void) { return trigger_is_double(g_trigger); }
-BOOL cfg_is_drag_trigger(void)   { return trigger_is_drag(g_trigger); }
+BOOL cfg_is_single_trigger(void) { return trigger_is_single(snap()->trigger); }
+BOOL cfg_is_double_trigger(void) { return trigger_is_double(snap()->trigger); }
+BOOL cfg_is_drag_trigger(void)   { return trigger_is_drag(snap()->trigger); }
+
+BOOL cfg_is_trigger_vk(int vk) {
+    return (snap()->trigger_keys[(vk >> 5) & 7] >> (vk & 31)) & 1;
+}
 
 BOOL cfg_is_trigger_key(const KeyboardEvent *ke) {
-    return ke_vk_code(ke) == g_target_vk_code;
+    return cfg_is_trigger_vk(ke_vk_code(ke) & 0xFF);
+}
+
+int cfg_get_scroll_key_options(void) { return g_scroll_key_opts; }
+
+int cfg_get_scroll_key(void) { return g_scroll_key; }
+
+/* ========== Runtime state word ========== */
+
+LONG cfg_get_state(void) { return g_state; }
+
+/* Atomically clear then set bits; returns the new state */
+LONG cfg_update_state(LONG clear, LONG set) {
+    LONG old, nw;
+    do {
+        old = g_state;
+        nw = (old & ~clear) | set;
+    } while (InterlockedCompareExchange(&g_state, nw, old) != old);
+    return nw;
+}
+
+/* Applies one of the runstate.h transitions; returns the new state */
+static LONG state_apply(LONG (*fn)(LONG)) {
+    LONG old, nw;
+    do {
+        old = g_state;
+        nw = fn(old);
+    } while (InterlockedCompareExchange(&g_state, nw, old) != old);
+    return nw;
 }
 
 /* ========== Pass mode ========== */
 
-BOOL cfg_is_pass_mode(void)   { return g_pass_mode; }
-void cfg_set_pass_mode(BOOL b) { g_pass_mode = b; }
+BOOL cfg_is_pass_mode(void) { return (g_state & RS_PASS_MODE) != 0; }
+
+void cfg_set_pass_mode(BOOL b) {
+    if (b) cfg_update_state(0, RS_PASS_MODE);
+    else   cfg_update_state(RS_PASS_MODE, 0);
+    notify_mouse_demand();
+}
+
+/*
+ * A mouse trigger needs every event. With trigger None the hook is only
+ * needed during a (keyboard) scroll session and until its suppressed
+ * mouse ups have been consumed.
+ */
+BOOL cfg_is_mouse_hook_needed(void) {
+    LONG st = g_state;
+    if (st & RS_PASS_MODE) return FALSE;
+    /* Pinned here: the hook thread asks outside any event */
+    cfg_read_begin();
+    BOOL mouse_trigger = snap()->trigger != TRIGGER_NONE;
+    cfg_read_end();
+    if (mouse_trigger) return TRUE;
+    return (st & (RS_SCROLL_MODE | RS_SCROLL_STARTING)) != 0 ||
+           g_last_flags.mouse != 0;
+}
 
 /* ========== Scroll state ========== */
 
-BOOL cfg_is_scroll_mode(void) { return g_scroll_mode; }
+BOOL cfg_is_scroll_mode(void) { return (g_state & RS_SCROLL_MODE) != 0; }
 
 void cfg_start_scroll(const MSLLHOOKSTRUCT *info) {
     EnterCriticalSection(&g_scroll_cs);
     g_scroll_start_time = info->time;
+    g_scroll_key_opts = 0;
+    g_scroll_key = 0;
     g_scroll_start_x = info->pt.x;
     g_scroll_start_y = info->pt.y;
 
     if (g_init_scroll_cb) g_init_scroll_cb();
     rawinput_register();
 
-    if (g_cursor_change && !trigger_is_drag(g_trigger))
+    const CfgSnapshot *s = snap();
+    if (s->flag[CFG_B_CURSOR_CHANGE] && !trigger_is_drag(s->trigger))
         cursor_change_v();
 
-    g_scroll_mode = TRUE;
-    g_scroll_starting = FALSE;
+    LONG st = state_apply(rs_start);
     LeaveCriticalSection(&g_scroll_cs);
+    notify_mouse_demand();
+
+    /* The second trigger up overtook this start (cfg_exit_scroll_deferred) */
+    if (st & RS_EXIT_PENDING)
+        cfg_exit_scroll();
 }
 
 void cfg_start_scroll_k(const KBDLLHOOKSTRUCT *info) {
     EnterCriticalSection(&g_scroll_cs);
     g_scroll_start_time = info->time;
+    g_scroll_key_opts = snap()->key_opts[info->vkCode & 0xFF];
+    g_scroll_key = (int)(info->vkCode & 0xFF);
 
     POINT pt;
     GetCursorPos(&pt);
@@ -468,27 +850,57 @@ void cfg_start_scroll_k(const KBDLLHOOKSTRUCT *info) {
     if (g_init_scroll_cb) g_init_scroll_cb();
     rawinput_register();
 
-    if (g_cursor_change)
+    if (snap()->flag[CFG_B_CURSOR_CHANGE])
         cursor_change_v();
 
-    g_scroll_mode = TRUE;
-    g_scroll_starting = FALSE;
+    state_apply(rs_start);
     LeaveCriticalSection(&g_scroll_cs);
+    notify_mouse_demand();
+}
+
+/*
+ * A trigger down that may start a session (chord wait, drag before its
+ * threshold): build the session plan now, so the confirmed start only
+ * resets counters. Only the cached plan: with the default LR trigger
+ * every plain click is a candidate, so raw input is left to the
+ * confirmed start (or persistent mode). Skipped while a session is
+ * live, whose plan it would overwrite.
+ */
+void cfg_prepare_scroll(void) {
+    if (g_state & (RS_SCROLL_MODE | RS_SCROLL_STARTING)) return;
+    if (g_prepare_scroll_cb) g_prepare_scroll_cb();
 }
 
 void cfg_exit_scroll(void) {
     EnterCriticalSection(&g_scroll_cs);
     rawinput_unregister();
-    g_scroll_mode = FALSE;
-    g_scroll_released = FALSE;
-    if (g_cursor_change)
+    state_apply(rs_exit);
+    if (g_exit_scroll_cb) g_exit_scroll_cb();
+    if (snap()->flag[CFG_B_CURSOR_CHANGE])
         cursor_restore();
     LeaveCriticalSection(&g_scroll_cs);
+    notify_mouse_demand();
+}
+
+/*
+ * Exit now if the start has committed, otherwise leave RS_EXIT_PENDING
+ * for cfg_start_scroll to act on. Both sides go through the state word,
+ * so exactly one of them performs the exit.
+ */
+void cfg_exit_scroll_deferred(void) {
+    LONG old;
+    do {
+        old = g_state;
+        if (old & RS_SCROLL_MODE) {
+            cfg_exit_scroll();
+            return;
+        }
+    } while (InterlockedCompareExchange(&g_state, rs_defer_exit(old), old) != old);
 }
 
 BOOL cfg_check_exit_scroll(DWORD time) {
     DWORD dt = time - g_scroll_start_time;
-    return dt > (DWORD)g_scroll_locktime;
+    return dt > (DWORD)snap()->num[CFG_N_SCROLL_LOCKTIME];
 }
 
 void cfg_get_scroll_start_point(int *x, int *y) {
@@ -496,72 +908,72 @@ void cfg_get_scroll_start_point(int *x, int *y) {
     *y = g_scroll_start_y;
 }
 
-BOOL cfg_is_released_scroll(void) { return g_scroll_released; }
+BOOL cfg_is_released_scroll(void) { return (g_state & RS_SCROLL_RELEASED) != 0; }
 
 BOOL cfg_is_pressed_scroll(void) {
-    return g_scroll_mode && !g_scroll_released;
+    return (g_state & (RS_SCROLL_MODE | RS_SCROLL_RELEASED)) == RS_SCROLL_MODE;
 }
 
-void cfg_set_released_scroll(void) { g_scroll_released = TRUE; }
+void cfg_set_released_scroll(void) { cfg_update_state(0, RS_SCROLL_RELEASED); }
 
-void cfg_set_starting_scroll(void) {
-    EnterCriticalSection(&g_scroll_cs);
-    g_scroll_starting = !g_scroll_mode;
-    LeaveCriticalSection(&g_scroll_cs);
-}
+/* Starting = second trigger down offered while scroll mode is not yet on */
+void cfg_set_starting_scroll(void) { state_apply(rs_starting); }
 
-BOOL cfg_is_starting_scroll(void) { return g_scroll_starting; }
+BOOL cfg_is_starting_scroll(void) { return (g_state & RS_SCROLL_STARTING) != 0; }
 
 /* ========== Scroll options ========== */
 
-int  cfg_get_scroll_locktime(void)    { return g_scroll_locktime; }
-BOOL cfg_is_cursor_change(void)       { return g_cursor_change; }
-BOOL cfg_is_reverse_scroll(void)      { return g_reverse_scroll; }
-BOOL cfg_is_horizontal_scroll(void)   { return g_horizontal_scroll; }
-BOOL cfg_is_dragged_lock(void)        { return g_dragged_lock; }
-BOOL cfg_is_swap_scroll(void)         { return g_swap_scroll; }
+int  cfg_get_scroll_locktime(void)    { return snap()->num[CFG_N_SCROLL_LOCKTIME]; }
+BOOL cfg_is_cursor_change(void)       { return snap()->flag[CFG_B_CURSOR_CHANGE]; }
+BOOL cfg_is_reverse_scroll(void)      { return snap()->flag[CFG_B_REVERSE_SCROLL]; }
+BOOL cfg_is_horizontal_scroll(void)   { return snap()->flag[CFG_B_HORIZONTAL_SCROLL]; }
+BOOL cfg_is_dragged_lock(void)        { return snap()->flag[CFG_B_DRAGGED_LOCK]; }
+BOOL cfg_is_swap_scroll(void)         { return snap()->flag[CFG_B_SWAP_SCROLL]; }
 
 /* ========== Real wheel ========== */
 
-BOOL cfg_is_real_wheel_mode(void) { return g_real_wheel_mode; }
-int  cfg_get_wheel_delta(void)    { return g_wheel_delta; }
-int  cfg_get_v_wheel_move(void)   { return g_v_wheel_move; }
-int  cfg_get_h_wheel_move(void)   { return g_h_wheel_move; }
-BOOL cfg_is_quick_first(void)     { return g_quick_first; }
-BOOL cfg_is_quick_turn(void)      { return g_quick_turn; }
+BOOL cfg_is_real_wheel_mode(void) { return snap()->flag[CFG_B_REAL_WHEEL_MODE]; }
+int  cfg_get_wheel_delta(void)    { return snap()->num[CFG_N_WHEEL_DELTA]; }
+int  cfg_get_v_wheel_move(void)   { return snap()->num[CFG_N_V_WHEEL_MOVE]; }
+int  cfg_get_h_wheel_move(void)   { return snap()->num[CFG_N_H_WHEEL_MOVE]; }
+BOOL cfg_is_quick_first(void)     { return snap()->flag[CFG_B_QUICK_FIRST]; }
+BOOL cfg_is_quick_turn(void)      { return snap()->flag[CFG_B_QUICK_TURN]; }
 
 /* ========== Acceleration ========== */
 
-BOOL cfg_is_accel_table(void) { return g_accel_table; }
-AccelPreset cfg_get_accel_preset(void) { return g_accel_preset; }
-BOOL cfg_is_custom_accel(void) { return g_custom_accel; }
+BOOL cfg_is_accel_table(void) { return snap()->flag[CFG_B_ACCEL_TABLE]; }
+AccelPreset cfg_get_accel_preset(void) { return snap()->accel_preset; }
+BOOL cfg_is_custom_accel(void) { return snap()->flag[CFG_B_CUSTOM_ACCEL_TABLE]; }
 
 const int *cfg_get_accel_threshold(int *count) {
-    if (!g_custom_accel_disabled && g_custom_accel) {
-        *count = g_custom_accel_count;
-        return g_custom_threshold;
+    const CfgSnapshot *s = snap();
+    if (!s->custom_accel_disabled && s->flag[CFG_B_CUSTOM_ACCEL_TABLE]) {
+        *count = s->custom_accel_count;
+        return s->custom_threshold;
     }
     *count = ACCEL_TABLE_SIZE;
     return DEFAULT_ACCEL_THRESHOLD;
 }
 
 const double *cfg_get_accel_multiplier(int *count) {
-    if (!g_custom_accel_disabled && g_custom_accel) {
-        *count = g_custom_accel_count;
-        return g_custom_multiplier;
+    const CfgSnapshot *s = snap();
+    if (!s->custom_accel_disabled && s->flag[CFG_B_CUSTOM_ACCEL_TABLE]) {
+        *count = s->custom_accel_count;
+        return s->custom_multiplier;
     }
     *count = ACCEL_TABLE_SIZE;
-    return accel_preset_array(g_accel_preset);
+    return accel_preset_array(s->accel_preset);
 }
 
 void cfg_get_custom_accel_strings(wchar_t *thr_buf, int thr_size,
                                   wchar_t *mul_buf, int mul_size) {
+    const CfgSnapshot *s = snap();
     thr_buf[0] = L'\0';
     mul_buf[0] = L'\0';
-    if (g_custom_accel_count == 0) return;
+    if (s->custom_accel_count == 0) return;
 
     int thr_off = 0, mul_off = 0;
-    for (int i = 0; i < g_custom_accel_count; i++) {
+    for (int i = 0; i < s->custom_accel_count; i++) {
         int n;
         if (i > 0) {
             if (thr_off < thr_size - 1)
@@ -570,9 +982,9 @@ void cfg_get_custom_accel_strings(wchar_t *thr_buf, int thr_size,
                 { n = _snwprintf(mul_buf + mul_off, mul_size - mul_off, L","); if (n > 0) mul_off += n; }
         }
         if (thr_off < thr_size - 1)
-            { n = _snwprintf(thr_buf + thr_off, thr_size - thr_off, L"%d", g_custom_threshold[i]); if (n > 0) thr_off += n; }
+            { n = _snwprintf(thr_buf + thr_off, thr_size - thr_off, L"%d", s->custom_threshold[i]); if (n > 0) thr_off += n; }
         if (mul_off < mul_size - 1)
-            { n = _snwprintf(mul_buf + mul_off, mul_size - mul_off, L"%.1f", g_custom_multiplier[i]); if (n > 0) mul_off += n; }
+            { n = _snwprintf(mul_buf + mul_off, mul_size - mul_off, L"%.1f", s->custom_multiplier[i]); if (n > 0) mul_off += n; }
     }
     thr_buf[thr_size - 1] = L'\0';
     mul_buf[mul_size - 1] = L'\0';
@@ -599,10 +1011,12 @@ BOOL cfg_set_custom_accel_strings(const wchar_t *thresholds, const wchar_t *mult
     }
 
     if (tc > 0 && tc == mc) {
-        memcpy(g_custom_threshold, tmp_thr, tc * sizeof(int));
-        memcpy(g_custom_multiplier, tmp_mul, tc * sizeof(double));
-        g_custom_accel_count = tc;
-        g_custom_accel_disabled = FALSE;
+        cfg_begin_update();
+        memcpy(g_draft.custom_threshold, tmp_thr, tc * sizeof(int));
+        memcpy(g_draft.custom_multiplier, tmp_mul, tc * sizeof(double));
+        g_draft.custom_accel_count = tc;
+        g_draft.custom_accel_disabled = FALSE;
+        cfg_end_update();
         prop_set(L"customAccelThreshold", thresholds);
         prop_set(L"customAccelMultiplier", multipliers);
         return TRUE;
@@ -613,38 +1027,178 @@ BOOL cfg_set_custom_accel_strings(const wchar_t *thresholds, const wchar_t *mult
 /* ========== VH adjuster ========== */
 
 BOOL cfg_is_vh_adjuster_mode(void) {
-    return g_horizontal_scroll && g_vh_adjuster_mode;
+    const CfgSnapshot *s = snap();
+    return s->flag[CFG_B_HORIZONTAL_SCROLL] && s->flag[CFG_B_VH_ADJUSTER_MODE];
 }
-BOOL cfg_is_vh_adjuster_switching(void) { return g_vh_method == VH_SWITCHING; }
-BOOL cfg_is_first_prefer_vertical(void) { return g_first_prefer_vertical; }
-int  cfg_get_first_min_threshold(void)  { return g_first_min_threshold; }
-int  cfg_get_switching_threshold(void)  { return g_switching_threshold; }
+BOOL cfg_is_vh_adjuster_switching(void) { return snap()->vh_method == VH_SWITCHING; }
+BOOL cfg_is_first_prefer_vertical(void) { return snap()->flag[CFG_B_FIRST_PREFER_VERTICAL]; }
+int  cfg_get_first_min_threshold(void)  { return snap()->num[CFG_N_FIRST_MIN_THRESHOLD]; }
+int  cfg_get_switching_threshold(void)  { return snap()->num[CFG_N_SWITCHING_THRESHOLD]; }
 
 /* ========== Thresholds ========== */
 
-int cfg_get_vertical_threshold(void)   { return g_vertical_threshold; }
-int cfg_get_horizontal_threshold(void) { return g_horizontal_threshold; }
-int cfg_get_hook_health_check(void)    { return g_hook_health_check; }
+int cfg_get_vertical_threshold(void)   { return snap()->num[CFG_N_VERTICAL_THRESHOLD]; }
+int cfg_get_horizontal_threshold(void) { return snap()->num[CFG_N_HORIZONTAL_THRESHOLD]; }
+int cfg_get_hook_health_check(void)    { return snap()->num[CFG_N_HOOK_HEALTH_CHECK]; }
 
 /* ========== Priority ========== */
 
-Priority cfg_get_priority(void) { return g_priority; }
+Priority cfg_get_priority(void) { return snap()->priority; }
 
+/* util_set_priority runs when the update publishes */
 void cfg_set_priority_name(const wchar_t *name) {
-    g_priority = priority_from_name(name);
-    util_set_priority(g_priority);
+    cfg_begin_update();
+    g_draft.priority = priority_from_name(name);
+    cfg_end_update();
 }
 
 void cfg_set_accel_multiplier_name(const wchar_t *name) {
-    g_accel_preset = accel_preset_from_name(name);
+    cfg_begin_update();
+    g_draft.accel_preset = accel_preset_from_name(name);
+    cfg_end_update();
 }
 
+/*
+ * Trigger key list: "VK_NONCONVERT,VK_APPS:reverse:swap". The first key is
+ * the primary one shown in the settings dialog. A single name (the old
+ * format) still works.
+ */
 void cfg_set_vk_code_name(const wchar_t *name) {
-    g_target_vk_code = vk_code_from_name(name);
+    LONG keys[8] = { 0 };
+    BYTE opts[256] = { 0 };
+    int primary = 0;
+    wchar_t buf[MAX_VAL_LEN];
+    wchar_t *ctx = NULL;
+
+    wcsncpy(buf, name, MAX_VAL_LEN - 1);
+    buf[MAX_VAL_LEN - 1] = L'\0';
+
+    for (wchar_t *tok = wcstok(buf, L",", &ctx); tok; tok = wcstok(NULL, L",", &ctx)) {
+        while (*tok == L' ') tok++;
+        wchar_t *opt = wcschr(tok, L':');
+        if (opt) *opt++ = L'\0';
+        int vk = vk_code_from_name(tok);
+        if (vk == 0) continue;
+
+        BYTE o = 0;
+        while (opt && *opt) {
+            wchar_t *next = wcschr(opt, L':');
+            if (next) *next++ = L'\0';
+            if (_wcsicmp(opt, L"reverse") == 0) o |= KO_REVERSE;
+            else if (_wcsicmp(opt, L"swap") == 0) o |= KO_SWAP;
+            opt = next;
+        }
+        keys[vk >> 5] |= (LONG)(1u << (vk & 31));
+        opts[vk] = o;
+        if (!primary) primary = vk;
+    }
+
+    cfg_begin_update();
+    memcpy(g_draft.key_opts, opts, sizeof(g_draft.key_opts));
+    memcpy(g_draft.trigger_keys, keys, sizeof(g_draft.trigger_keys));
+    g_draft.target_vk_code = primary;
+    cfg_end_update();
+}
+
+void cfg_get_vk_code_names(wchar_t *buf, int size) {
+    int len = 0;
+    buf[0] = L'\0';
+
+    const CfgSnapshot *s = snap();
+
+    /* Primary first, then the rest in code order */
+    for (int pass = 0; pass < 2; pass++) {
+        for (int vk = 1; vk < 256; vk++) {
+            if (!((s->trigger_keys[vk >> 5] >> (vk & 31)) & 1)) continue;
+            if ((pass == 0) != (vk == s->target_vk_code)) continue;
+
+            wchar_t name[32];
+            vk_format_name(vk, name, 32);
+            len += _snwprintf(buf + len, size - len, L"%s%s%s%s", len ? L"," : L"", name,
+                              (s->key_opts[vk] & KO_REVERSE) ? L":reverse" : L"",
+                              (s->key_opts[vk] & KO_SWAP) ? L":swap" : L"");
+            if (len < 0 || len >= size) {
+                buf[size - 1] = L'\0';
+                return;
+            }
+        }
+    }
+    if (len == 0) _snwprintf(buf, size, L"None");
+}
+
+/* ========== Chatter filter thresholds ========== */
+
+static void debounce_rebuild(void) {
+    BOOL any = FALSE;
+    for (int vk = 0; vk < 256; vk++) {
+        int ms = g_draft.debounce_override[vk] >= 0 ? g_draft.debounce_override[vk]
+                                                    : g_draft.num[CFG_N_DEBOUNCE_TIME];
+        g_draft.debounce_ms[vk] = (BYTE)(ms < 0 ? 0 : ms > 255 ? 255 : ms);
+        if (g_draft.debounce_ms[vk]) any = TRUE;
+    }
+    g_draft.debounce_any = any;
+}
+
+/* "NAME:ms,..." where NAME is a VK_* name or hex code */
+void cfg_set_debounce_keys(const wchar_t *list) {
+    wchar_t buf[MAX_VAL_LEN];
+    wchar_t *ctx = NULL;
+
+    wcsncpy(buf, list, MAX_VAL_LEN - 1);
+    buf[MAX_VAL_LEN - 1] = L'\0';
+
+    cfg_begin_update();
+    for (int vk = 0; vk < 256; vk++)
+        g_draft.debounce_override[vk] = -1;
+    for (wchar_t *tok = wcstok(buf, L",", &ctx); tok; tok = wcstok(NULL, L",", &ctx)) {
+        while (*tok == L' ') tok++;
+        wchar_t *ms = wcschr(tok, L':');
+        if (!ms) continue;
+        *ms++ = L'\0';
+        int vk = vk_code_from_name(tok);
+        if (vk == 0) continue;
+        int n = _wtoi(ms);
+        g_draft.debounce_override[vk] = (SHORT)(n < 0 ? 0 : n > 255 ? 255 : n);
+    }
+    debounce_rebuild();
+    cfg_end_update();
+}
+
+void cfg_get_debounce_keys(wchar_t *buf, int size) {
+    const CfgSnapshot *s = snap();
+    int len = 0;
+    buf[0] = L'\0';
+    for (int vk = 1; vk < 256; vk++) {
+        if (s->debounce_override[vk] < 0) continue;
+        wchar_t name[32];
+        vk_format_name(vk, name, 32);
+        len += _snwprintf(buf + len, size - len, L"%s%s:%d", len ? L"," : L"",
+                          name, s->debounce_override[vk]);
+        if (len < 0 || len >= size) {
+            buf[size - 1] = L'\0';
+            return;
+        }
+    }
+}
+
+/* ========== Raw input device allow-list ========== */
+
+/* Handed to the raw input reader when the update publishes */
+void cfg_set_raw_device_allow(const wchar_t *list) {
+    cfg_begin_update();
+    wcsncpy(g_draft.raw_device_allow, list, 255);
+    g_draft.raw_device_allow[255] = L'\0';
+    cfg_end_update();
+}
+
+const wchar_t *cfg_get_raw_device_allow(void) {
+    return snap()->raw_device_allow;
 }
 
 void cfg_set_vh_method_name(const wchar_t *name) {
-    g_vh_method = vh_method_from_name(name);
+    cfg_begin_update();
+    g_draft.vh_method = vh_method_from_name(name);
+    cfg_end_update();
 }
 
 /* ========== LastFlags ========== */
@@ -652,317 +1206,212 @@ void cfg_set_vh_method_name(const wchar_t *name) {
 LastFlags *cfg_last_flags(void) { return &g_last_flags; }
 
 void cfg_last_flags_init(void) {
-    memset(&g_last_flags, 0, sizeof(g_last_flags));
+    InterlockedExchange(&g_last_flags.mouse, 0);
+    for (int i = 0; i < 8; i++)
+        InterlockedExchange(&g_last_flags.kd_suppressed[i], 0);
 }
 
 void cfg_last_flags_set_resent(const MouseEvent *me) {
-    if (me->type == ME_LEFT_DOWN) g_last_flags.ld_resent = TRUE;
-    else if (me->type == ME_RIGHT_DOWN) g_last_flags.rd_resent = TRUE;
+    if (me->type == ME_LEFT_DOWN) lf_set(&g_last_flags.mouse, LF_LD_RESENT);
+    else if (me->type == ME_RIGHT_DOWN) lf_set(&g_last_flags.mouse, LF_RD_RESENT);
 }
 
 BOOL cfg_last_flags_get_reset_resent(const MouseEvent *me) {
-    BOOL *flag = NULL;
-    if (me->type == ME_LEFT_UP) flag = (BOOL *)&g_last_flags.ld_resent;
-    else if (me->type == ME_RIGHT_UP) flag = (BOOL *)&g_last_flags.rd_resent;
-    if (!flag) return FALSE;
-    BOOL val = *flag; *flag = FALSE; return val;
+    if (me->type == ME_LEFT_UP) return lf_get_reset(&g_last_flags.mouse, LF_LD_RESENT);
+    if (me->type == ME_RIGHT_UP) return lf_get_reset(&g_last_flags.mouse, LF_RD_RESENT);
+    return FALSE;
 }
 
 void cfg_last_flags_set_passed(const MouseEvent *me) {
-    if (me->type == ME_LEFT_DOWN) g_last_flags.ld_passed = TRUE;
-    else if (me->type == ME_RIGHT_DOWN) g_last_flags.rd_passed = TRUE;
+    if (me->type == ME_LEFT_DOWN) lf_set(&g_last_flags.mouse, LF_LD_PASSED);
+    else if (me->type == ME_RIGHT_DOWN) lf_set(&g_last_flags.mouse, LF_RD_PASSED);
 }
 
 BOOL cfg_last_flags_get_reset_passed(const MouseEvent *me) {
-    BOOL *flag = NULL;
-    if (me->type == ME_LEFT_UP) flag = (BOOL *)&g_last_flags.ld_passed;
-    else if (me->type == ME_RIGHT_UP) flag = (BOOL *)&g_last_flags.rd_passed;
-    if (!flag) return FALSE;
-    BOOL val = *flag; *flag = FALSE; return val;
+    if (me->type == ME_LEFT_UP) return lf_get_reset(&g_last_flags.mouse, LF_LD_PASSED);
+    if (me->type == ME_RIGHT_UP) return lf_get_reset(&g_last_flags.mouse, LF_RD_PASSED);
+    return FALSE;
 }
 
 void cfg_last_flags_set_suppressed(const MouseEvent *me) {
     switch (me->type) {
-    case ME_LEFT_DOWN: g_last_flags.ld_suppressed = TRUE; break;
-    case ME_RIGHT_DOWN: g_last_flags.rd_suppressed = TRUE; break;
+    case ME_LEFT_DOWN: lf_set(&g_last_flags.mouse, LF_LD_SUPPRESSED); break;
+    case ME_RIGHT_DOWN: lf_set(&g_last_flags.mouse, LF_RD_SUPPRESSED); break;
     case ME_MIDDLE_DOWN: case ME_X1_DOWN: case ME_X2_DOWN:
-        g_last_flags.sd_suppressed = TRUE; break;
+        lf_set(&g_last_flags.mouse, LF_SD_SUPPRESSED); break;
     default: break;
     }
 }
 
 void cfg_last_flags_set_suppressed_k(const KeyboardEvent *ke) {
     if (ke->type == KE_KEY_DOWN)
-        g_last_flags.kd_suppressed[ke_vk_code(ke) & 0xFF] = TRUE;
+        lf_set_key(&g_last_flags, ke_vk_code(ke));
 }
 
 BOOL cfg_last_flags_get_reset_suppressed(const MouseEvent *me) {
-    BOOL *flag = NULL;
     switch (me->type) {
-    case ME_LEFT_UP: flag = (BOOL *)&g_last_flags.ld_suppressed; break;
-    case ME_RIGHT_UP: flag = (BOOL *)&g_last_flags.rd_suppressed; break;
+    case ME_LEFT_UP: return lf_get_reset(&g_last_flags.mouse, LF_LD_SUPPRESSED);
+    case ME_RIGHT_UP: return lf_get_reset(&g_last_flags.mouse, LF_RD_SUPPRESSED);
     case ME_MIDDLE_UP: case ME_X1_UP: case ME_X2_UP:
-        flag = (BOOL *)&g_last_flags.sd_suppressed; break;
+        return lf_get_reset(&g_last_flags.mouse, LF_SD_SUPPRESSED);
     default: return FALSE;
     }
-    BOOL val = *flag; *flag = FALSE; return val;
 }
 
 BOOL cfg_last_flags_get_reset_suppressed_k(const KeyboardEvent *ke) {
     if (ke->type != KE_KEY_UP) return FALSE;
-    int idx = ke_vk_code(ke) & 0xFF;
-    BOOL val = g_last_flags.kd_suppressed[idx];
-    g_last_flags.kd_suppressed[idx] = FALSE;
-    return val;
+    return lf_get_reset_key(&g_last_flags, ke_vk_code(ke));
 }
 
 void cfg_last_flags_reset_lr(const MouseEvent *me) {
-    if (me->type == ME_LEFT_DOWN) {
-        g_last_flags.ld_resent = FALSE;
-        g_last_flags.ld_suppressed = FALSE;
-        g_last_flags.ld_passed = FALSE;
-    } else if (me->type == ME_RIGHT_DOWN) {
-        g_last_flags.rd_resent = FALSE;
-        g_last_flags.rd_suppressed = FALSE;
-        g_last_flags.rd_passed = FALSE;
-    }
+    if (me->type == ME_LEFT_DOWN)
+        InterlockedAnd(&g_last_flags.mouse, ~(LF_LD_RESENT | LF_LD_SUPPRESSED | LF_LD_PASSED));
+    else if (me->type == ME_RIGHT_DOWN)
+        InterlockedAnd(&g_last_flags.mouse, ~(LF_RD_RESENT | LF_RD_SUPPRESSED | LF_RD_PASSED));
 }
 
 /* ========== Number settings by name ========== */
 
 int cfg_get_number(const wchar_t *name) {
-    if (wcscmp(name, L"pollTimeout") == 0) return g_poll_timeout;
-    if (wcscmp(name, L"scrollLocktime") == 0) return g_scroll_locktime;
-    if (wcscmp(name, L"verticalThreshold") == 0) return g_vertical_threshold;
-    if (wcscmp(name, L"horizontalThreshold") == 0) return g_horizontal_threshold;
-    if (wcscmp(name, L"wheelDelta") == 0) return g_wheel_delta;
-    if (wcscmp(name, L"vWheelMove") == 0) return g_v_wheel_move;
-    if (wcscmp(name, L"hWheelMove") == 0) return g_h_wheel_move;
-    if (wcscmp(name, L"firstMinThreshold") == 0) return g_first_min_threshold;
-    if (wcscmp(name, L"switchingThreshold") == 0) return g_switching_threshold;
-    if (wcscmp(name, L"dragThreshold") == 0) return g_drag_threshold;
-    if (wcscmp(name, L"hookHealthCheck") == 0) return g_hook_health_check;
-    if (wcscmp(name, L"fkAcceptanceDelay") == 0) return g_fk_acceptance_delay;
-    if (wcscmp(name, L"fkRepeatDelay") == 0) return g_fk_repeat_delay;
-    if (wcscmp(name, L"fkRepeatRate") == 0) return g_fk_repeat_rate;
-    if (wcscmp(name, L"fkBounceTime") == 0) return g_fk_bounce_time;
-    if (wcscmp(name, L"kbRepeatDelay") == 0) return g_kb_repeat_delay;
-    if (wcscmp(name, L"kbRepeatSpeed") == 0) return g_kb_repeat_speed;
-    return 0;
+    const CfgEntry *e = schema_find(name);
+    if (!e || e->type != CFG_TYPE_NUMBER) return 0;
+    return snap()->num[e->slot];
 }
 
 void cfg_set_number(const wchar_t *name, int n) {
-    if (wcscmp(name, L"pollTimeout") == 0) g_poll_timeout = n;
-    else if (wcscmp(name, L"scrollLocktime") == 0) g_scroll_locktime = n;
-    else if (wcscmp(name, L"verticalThreshold") == 0) g_vertical_threshold = n;
-    else if (wcscmp(name, L"horizontalThreshold") == 0) g_horizontal_threshold = n;
-    else if (wcscmp(name, L"wheelDelta") == 0) g_wheel_delta = n;
-    else if (wcscmp(name, L"vWheelMove") == 0) g_v_wheel_move = n;
-    else if (wcscmp(name, L"hWheelMove") == 0) g_h_wheel_move = n;
-    else if (wcscmp(name, L"firstMinThreshold") == 0) g_first_min_threshold = n;
-    else if (wcscmp(name, L"switchingThreshold") == 0) g_switching_threshold = n;
-    else if (wcscmp(name, L"dragThreshold") == 0) g_drag_threshold = n;
-    else if (wcscmp(name, L"hookHealthCheck") == 0) g_hook_health_check = n;
-    else if (wcscmp(name, L"fkAcceptanceDelay") == 0) g_fk_acceptance_delay = n;
-    else if (wcscmp(name, L"fkRepeatDelay") == 0) g_fk_repeat_delay = n;
-    else if (wcscmp(name, L"fkRepeatRate") == 0) g_fk_repeat_rate = n;
-    else if (wcscmp(name, L"fkBounceTime") == 0) g_fk_bounce_time = n;
-    else if (wcscmp(name, L"kbRepeatDelay") == 0) g_kb_repeat_delay = n;
-    else if (wcscmp(name, L"kbRepeatSpeed") == 0) g_kb_repeat_speed = n;
+    const CfgEntry *e = schema_find(name);
+    if (!e || e->type != CFG_TYPE_NUMBER) return;
+    cfg_begin_update();
+    g_draft.num[e->slot] = n;
+    if (e->slot == CFG_N_DEBOUNCE_TIME) debounce_rebuild();
+    cfg_end_update();
 }
 
 /* ========== Boolean settings by name ========== */
 
 BOOL cfg_get_boolean(const wchar_t *name) {
-    if (wcscmp(name, L"realWheelMode") == 0) return g_real_wheel_mode;
-    if (wcscmp(name, L"cursorChange") == 0) return g_cursor_change;
-    if (wcscmp(name, L"horizontalScroll") == 0) return g_horizontal_scroll;
-    if (wcscmp(name, L"reverseScroll") == 0) return g_reverse_scroll;
-    if (wcscmp(name, L"quickFirst") == 0) return g_quick_first;
-    if (wcscmp(name, L"quickTurn") == 0) return g_quick_turn;
-    if (wcscmp(name, L"accelTable") == 0) return g_accel_table;
-    if (wcscmp(name, L"customAccelTable") == 0) return g_custom_accel;
-    if (wcscmp(name, L"draggedLock") == 0) return g_dragged_lock;
-    if (wcscmp(name, L"swapScroll") == 0) return g_swap_scroll;
-    if (wcscmp(name, L"sendMiddleClick") == 0) return g_send_middle_click;
-    if (wcscmp(name, L"keyboardHook") == 0) return g_keyboard_hook;
-    if (wcscmp(name, L"vhAdjusterMode") == 0) return g_vh_adjuster_mode;
-    if (wcscmp(name, L"firstPreferVertical") == 0) return g_first_prefer_vertical;
-    if (wcscmp(name, L"passMode") == 0) return g_pass_mode;
-    if (wcscmp(name, L"filterKeys") == 0) return g_filter_keys;
-    if (wcscmp(name, L"fkLock") == 0) return g_fk_lock;
+    const CfgEntry *e = schema_find(name);
+    if (e && e->type == CFG_TYPE_BOOL) return snap()->flag[e->slot];
+    if (wcscmp(name, L"passMode") == 0) return cfg_is_pass_mode();
     return FALSE;
 }
 
 void cfg_set_boolean(const wchar_t *name, BOOL b) {
-    if (wcscmp(name, L"realWheelMode") == 0) g_real_wheel_mode = b;
-    else if (wcscmp(name, L"cursorChange") == 0) g_cursor_change = b;
-    else if (wcscmp(name, L"horizontalScroll") == 0) g_horizontal_scroll = b;
-    else if (wcscmp(name, L"reverseScroll") == 0) g_reverse_scroll = b;
-    else if (wcscmp(name, L"quickFirst") == 0) g_quick_first = b;
-    else if (wcscmp(name, L"quickTurn") == 0) g_quick_turn = b;
-    else if (wcscmp(name, L"accelTable") == 0) g_accel_table = b;
-    else if (wcscmp(name, L"customAccelTable") == 0) g_custom_accel = b;
-    else if (wcscmp(name, L"draggedLock") == 0) g_dragged_lock = b;
-    else if (wcscmp(name, L"swapScroll") == 0) g_swap_scroll = b;
-    else if (wcscmp(name, L"sendMiddleClick") == 0) g_send_middle_click = b;
-    else if (wcscmp(name, L"keyboardHook") == 0) g_keyboard_hook = b;
-    else if (wcscmp(name, L"vhAdjusterMode") == 0) g_vh_adjuster_mode = b;
-    else if (wcscmp(name, L"firstPreferVertical") == 0) g_first_prefer_vertical = b;
-    else if (wcscmp(name, L"passMode") == 0) g_pass_mode = b;
-    else if (wcscmp(name, L"filterKeys") == 0) g_filter_keys = b;
-    else if (wcscmp(name, L"fkLock") == 0) g_fk_lock = b;
+    const CfgEntry *e = schema_find(name);
+    if (e && e->type == CFG_TYPE_BOOL) {
+        cfg_begin_update();
+        g_draft.flag[e->slot] = b;
+        cfg_end_update();
+    } else if (wcscmp(name, L"passMode") == 0) {
+        cfg_set_pass_mode(b);
+    }
 }
 
 /* ========== Properties I/O ========== */
 
-static const wchar_t *BOOLEAN_NAMES[] = {
-    L"realWheelMode", L"cursorChange", L"horizontalScroll", L"reverseScroll",
-    L"quickFirst", L"quickTurn", L"accelTable", L"customAccelTable",
-    L"draggedLock", L"swapScroll", L"sendMiddleClick", L"keyboardHook",
-    L"vhAdjusterMode", L"firstPreferVertical",
-    L"filterKeys", L"fkLock"
-};
-#define BOOLEAN_COUNT (sizeof(BOOLEAN_NAMES) / sizeof(BOOLEAN_NAMES[0]))
-
-typedef struct { const wchar_t *name; int low; int up; } NumberRange;
-static const NumberRange NUMBER_RANGES[] = {
-    { L"pollTimeout", 50, 500 },
-    { L"scrollLocktime", 150, 500 },
-    { L"verticalThreshold", 0, 500 },
-    { L"horizontalThreshold", 0, 500 },
-    { L"wheelDelta", 10, 500 },
-    { L"vWheelMove", 10, 500 },
-    { L"hWheelMove", 10, 500 },
-    { L"firstMinThreshold", 1, 10 },
-    { L"switchingThreshold", 10, 500 },
-    { L"dragThreshold", 0, 500 },
-    { L"hookHealthCheck", 0, 300 },
-    { L"fkAcceptanceDelay", 0, 10000 },
-    { L"fkRepeatDelay", 0, 10000 },
-    { L"fkRepeatRate", 0, 10000 },
-    { L"fkBounceTime", 0, 10000 },
-    { L"kbRepeatDelay", 0, 3 },
-    { L"kbRepeatSpeed", 0, 31 },
-};
-#define NUMBER_COUNT (sizeof(NUMBER_RANGES) / sizeof(NUMBER_RANGES[0]))
-
 void cfg_set_selected_properties(const wchar_t *name) {
+    EnterCriticalSection(&g_props_cs);
     wcsncpy(g_selected_props, name, 255);
     g_selected_props[255] = L'\0';
+    LeaveCriticalSection(&g_props_cs);
 }
 
+/* UI thread: the only writer, so its reads need no lock */
 const wchar_t *cfg_get_selected_properties(void) {
     return g_selected_props;
 }
 
+/* Any thread: the active profile's file, from a consistent name */
+void cfg_get_selected_properties_path(wchar_t *buf, int bufsize) {
+    EnterCriticalSection(&g_props_cs);
+    cfg_get_properties_path(g_selected_props, buf, bufsize);
+    LeaveCriticalSection(&g_props_cs);
+}
+
 static void apply_string_prop(const wchar_t *key, void (*setter)(const wchar_t *)) {
-    const wchar_t *v = prop_get(key);
+    wchar_t buf[MAX_VAL_LEN];
+    const wchar_t *v = prop_get(key, buf, MAX_VAL_LEN);
     if (v) setter(v);
 }
 
 static void apply_bool_props(void) {
-    for (int i = 0; i < (int)BOOLEAN_COUNT; i++) {
-        const wchar_t *v = prop_get(BOOLEAN_NAMES[i]);
-        if (v) cfg_set_boolean(BOOLEAN_NAMES[i], _wcsicmp(v, L"True") == 0);
+    for (int i = 0; i < SCHEMA_COUNT; i++) {
+        const CfgEntry *e = &g_schema[i];
+        if (e->type != CFG_TYPE_BOOL) continue;
+        const char *v = prop_get_utf8(e);
+        if (v) g_draft.flag[e->slot] = _stricmp(v, "True") == 0;
     }
 }
 
 static void apply_number_props(void) {
-    for (int i = 0; i < (int)NUMBER_COUNT; i++) {
-        const wchar_t *v = prop_get(NUMBER_RANGES[i].name);
+    for (int i = 0; i < SCHEMA_COUNT; i++) {
+        const CfgEntry *e = &g_schema[i];
+        if (e->type != CFG_TYPE_NUMBER) continue;
+        const char *v = prop_get_utf8(e);
         if (v) {
-            int n = _wtoi(v);
-            if (n >= NUMBER_RANGES[i].low && n <= NUMBER_RANGES[i].up)
-                cfg_set_number(NUMBER_RANGES[i].name, n);
+            int n = atoi(v);
+            if (n >= e->low && n <= e->up)
+                g_draft.num[e->slot] = n;
         }
     }
+    debounce_rebuild();
 }
 
 static void apply_custom_accel(void) {
-    const wchar_t *ts = prop_get(L"customAccelThreshold");
-    const wchar_t *ms = prop_get(L"customAccelMultiplier");
-    if (!ts || !ms) return;
-
     /* Parse comma-separated int array */
     wchar_t tbuf[1024], mbuf[1024];
-    wcsncpy(tbuf, ts, 1023); tbuf[1023] = L'\0';
-    wcsncpy(mbuf, ms, 1023); mbuf[1023] = L'\0';
+    if (!prop_get(L"customAccelThreshold", tbuf, 1024) ||
+        !prop_get(L"customAccelMultiplier", mbuf, 1024))
+        return;
 
     int tc = 0, mc = 0;
     wchar_t *ctx;
     wchar_t *tok = wcstok(tbuf, L",", &ctx);
     while (tok && tc < 64) {
-        g_custom_threshold[tc++] = _wtoi(tok);
+        g_draft.custom_threshold[tc++] = _wtoi(tok);
         tok = wcstok(NULL, L",", &ctx);
     }
     tok = wcstok(mbuf, L",", &ctx);
     while (tok && mc < 64) {
-        g_custom_multiplier[mc++] = _wcstod_l(tok, NULL, get_c_locale());
+        g_draft.custom_multiplier[mc++] = _wcstod_l(tok, NULL, get_c_locale());
         tok = wcstok(NULL, L",", &ctx);
     }
 
     if (tc > 0 && tc == mc) {
-        g_custom_accel_count = tc;
-        g_custom_accel_disabled = FALSE;
+        g_draft.custom_accel_count = tc;
+        g_draft.custom_accel_disabled = FALSE;
     }
 }
 
+/* Fills the draft; callers hold an update */
 static void cfg_set_defaults(void) {
-    /* String settings — use setters that fire callbacks */
+    /* String settings — setters parse the names */
     cfg_set_trigger(TRIGGER_LR);
-    g_accel_preset = ACCEL_PRESET_M5;
-    g_target_vk_code = 0x1D;
-    g_vh_method = VH_SWITCHING;
-
-    /* Booleans (match compile-time initializers) */
-    g_real_wheel_mode = FALSE;
-    g_cursor_change = TRUE;
-    g_horizontal_scroll = TRUE;
-    g_reverse_scroll = FALSE;
-    g_quick_first = FALSE;
-    g_quick_turn = FALSE;
-    g_accel_table = TRUE;
-    g_custom_accel = FALSE;
-    g_dragged_lock = FALSE;
-    g_swap_scroll = FALSE;
-    g_send_middle_click = FALSE;
-    g_keyboard_hook = FALSE;
-    g_vh_adjuster_mode = FALSE;
-    g_first_prefer_vertical = TRUE;
-    g_filter_keys = FALSE;
-    g_fk_lock = FALSE;
-
-    /* Numbers (match compile-time initializers) */
-    g_poll_timeout = 200;
-    g_scroll_locktime = 200;
-    g_vertical_threshold = 0;
-    g_horizontal_threshold = 75;
-    g_wheel_delta = 120;
-    g_v_wheel_move = 60;
-    g_h_wheel_move = 60;
-    g_first_min_threshold = 5;
-    g_switching_threshold = 50;
-    g_drag_threshold = 0;
-    g_hook_health_check = 0;
-    g_fk_acceptance_delay = 1000;
-    g_fk_repeat_delay = 1000;
-    g_fk_repeat_rate = 500;
-    g_fk_bounce_time = 0;
-    g_kb_repeat_delay = 1;
-    g_kb_repeat_speed = 31;
+    g_draft.accel_preset = ACCEL_PRESET_M5;
+    cfg_set_vk_code_name(L"VK_NONCONVERT");
+    g_draft.vh_method = VH_SWITCHING;
+    cfg_set_debounce_keys(L"");
+    cfg_set_raw_device_allow(L"");
+
+    /* Booleans and numbers */
+    for (int i = 0; i < SCHEMA_COUNT; i++) {
+        const CfgEntry *e = &g_schema[i];
+        if (e->type == CFG_TYPE_BOOL) g_draft.flag[e->slot] = e->def;
+        else if (e->type == CFG_TYPE_NUMBER) g_draft.num[e->slot] = e->def;
+    }
+    debounce_rebuild();
 
     /* Custom accel — disable, clear count */
-    g_custom_accel_disabled = TRUE;
-    g_custom_accel_count = 0;
+    g_draft.custom_accel_disabled = TRUE;
+    g_draft.custom_accel_count = 0;
 
-    /* Priority — use setter for side effect (util_set_priority) */
-    cfg_set_priority_name(L"AboveNormal");
+    g_draft.priority = PRIO_ABOVE_NORMAL;
 }
 
 void cfg_load_properties_file_only(void) {
     wchar_t path[MAX_PATH];
     cfg_get_properties_path(g_selected_props, path, MAX_PATH);
+    cfgstore_flush(STORE_WAIT);
     prop_clear();
     prop_load(path);
 }
@@ -970,44 +1419,59 @@ void cfg_load_properties_file_only(void) {
 void cfg_load_properties(BOOL update) {
     wchar_t path[MAX_PATH];
     cfg_get_properties_path(g_selected_props, path, MAX_PATH);
+    cfgstore_flush(STORE_WAIT);  /* read our own latest save */
 
-    if (update) {
-        prop_clear();
-        cfg_set_defaults();
-    }
+    /* File I/O and parsing stay outside the writer lock: until the update
+       below, only the property table (UI thread) changes */
+    if (update) prop_clear();
     prop_load(path);
 
+    /* One snapshot for the whole load: readers see old or new, never a mix */
+    cfg_begin_update();
+    if (update) cfg_set_defaults();
+
     apply_string_prop(L"firstTrigger", cfg_set_trigger_name);
     apply_string_prop(L"accelMultiplier", cfg_set_accel_multiplier_name);
     apply_custom_accel();
     apply_string_prop(L"processPriority", cfg_set_priority_name);
     apply_string_prop(L"targetVKCode", cfg_set_vk_code_name);
     apply_string_prop(L"vhAdjusterMethod", cfg_set_vh_method_name);
+    apply_string_prop(L"debounceKeys", cfg_set_debounce_keys);
+    apply_string_prop(L"rawDeviceAllow", cfg_set_raw_device_allow);
     apply_bool_props();
     apply_number_props();
 
     /* Set default priority if not specified */
-    if (!prop_get(L"processPriority"))
+    if (!prop_has(L"processPriority"))
         cfg_set_priority_name(L"AboveNormal");
+    cfg_end_update();
 }
 
 void cfg_store_properties(void) {
+    const CfgSnapshot *s = snap();
     wchar_t buf[32];
 
     /* Strings */
-    prop_set(L"firstTrigger", trigger_to_name(g_trigger));
-    prop_set(L"accelMultiplier", accel_preset_to_name(g_accel_preset));
-    prop_set(L"processPriority", priority_to_name(g_priority));
-    prop_set(L"targetVKCode", vk_name_from_code(g_target_vk_code));
-    prop_set(L"vhAdjusterMethod", vh_method_to_name(g_vh_method));
-    /* Booleans */
-    for (int i = 0; i < (int)BOOLEAN_COUNT; i++)
-        prop_set(BOOLEAN_NAMES[i], cfg_get_boolean(BOOLEAN_NAMES[i]) ? L"True" : L"False");
-
-    /* Numbers */
-    for (int i = 0; i < (int)NUMBER_COUNT; i++) {
-        _snwprintf(buf, 32, L"%d", cfg_get_number(NUMBER_RANGES[i].name));
-        prop_set(NUMBER_RANGES[i].name, buf);
+    prop_set(L"firstTrigger", trigger_to_name(s->trigger));
+    prop_set(L"accelMultiplier", accel_preset_to_name(s->accel_preset));
+    prop_set(L"processPriority", priority_to_name(s->priority));
+    wchar_t vk_names[MAX_VAL_LEN];
+    cfg_get_vk_code_names(vk_names, MAX_VAL_LEN);
+    prop_set(L"targetVKCode", vk_names);
+    prop_set(L"vhAdjusterMethod", vh_method_to_name(s->vh_method));
+    wchar_t db_keys[MAX_VAL_LEN];
+    cfg_get_debounce_keys(db_keys, MAX_VAL_LEN);
+    prop_set(L"debounceKeys", db_keys);
+    prop_set(L"rawDeviceAllow", s->raw_device_allow);
+    /* Booleans and numbers */
+    for (int i = 0; i < SCHEMA_COUNT; i++) {
+        const CfgEntry *e = &g_schema[i];
+        if (e->type == CFG_TYPE_BOOL) {
+            prop_set(e->name, s->flag[e->slot] ? L"True" : L"False");
+        } else if (e->type == CFG_TYPE_NUMBER) {
+            _snwprintf(buf, 32, L"%d", s->num[e->slot]);
+            prop_set(e->name, buf);
+        }
     }
 
     wchar_t path[MAX_PATH];
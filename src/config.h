@@ -7,6 +7,7 @@
 #define W10WHEEL_CONFIG_H
 
 #include "types.h"
+#include "runstate.h"
 
 /* ========== Global state ========== */
 
@@ -16,6 +17,7 @@ void          cfg_set_trigger(Trigger t);
 int           cfg_get_poll_timeout(void);
 int           cfg_get_drag_threshold(void);
 BOOL          cfg_is_keyboard_hook(void);
+BOOL          cfg_is_keyboard_hook_needed(void);
 int           cfg_get_target_vk_code(void);
 BOOL          cfg_is_send_middle_click(void);
 
@@ -23,11 +25,17 @@ BOOL          cfg_is_send_middle_click(void);
 BOOL          cfg_is_pass_mode(void);
 void          cfg_set_pass_mode(BOOL b);
 
+/* Runtime state word (RS_* bits in runstate.h) */
+LONG          cfg_get_state(void);
+LONG          cfg_update_state(LONG clear, LONG set);
+
 /* Scroll state */
 BOOL          cfg_is_scroll_mode(void);
 void          cfg_start_scroll(const MSLLHOOKSTRUCT *info);
 void          cfg_start_scroll_k(const KBDLLHOOKSTRUCT *info);
+void          cfg_prepare_scroll(void);
 void          cfg_exit_scroll(void);
+void          cfg_exit_scroll_deferred(void);
 BOOL          cfg_check_exit_scroll(DWORD time);
 void          cfg_get_scroll_start_point(int *x, int *y);
 BOOL          cfg_is_released_scroll(void);
@@ -37,6 +45,8 @@ void          cfg_set_starting_scroll(void);
 BOOL          cfg_is_starting_scroll(void);
 
 /* Scroll options */
+void          cfg_set_raw_device_allow(const wchar_t *list);
+const wchar_t *cfg_get_raw_device_allow(void);
 int           cfg_get_scroll_locktime(void);
 BOOL          cfg_is_cursor_change(void);
 BOOL          cfg_is_reverse_scroll(void);
@@ -84,6 +94,30 @@ BOOL          cfg_is_single_trigger(void);
 BOOL          cfg_is_double_trigger(void);
 BOOL          cfg_is_drag_trigger(void);
 BOOL          cfg_is_trigger_key(const KeyboardEvent *ke);
+BOOL          cfg_is_trigger_vk(int vk);
+
+/* Per trigger key scroll options (XORed into the global settings) */
+#define KO_REVERSE  0x01
+#define KO_SWAP     0x02
+
+int           cfg_get_scroll_key_options(void);
+int           cfg_get_scroll_key(void);   /* vk that started the session; 0 = mouse */
+
+/* Software key repeat: per key class delay and interval (ms) */
+#define KR_CLASS_DEFAULT 0
+#define KR_CLASS_NAV     1  /* arrows, Page Up/Down, Home, End */
+#define KR_CLASS_EDIT    2  /* Backspace, Delete */
+#define KR_CLASS_COUNT   3
+
+BOOL          cfg_is_sw_repeat(void);
+int           cfg_get_sw_repeat_delay(int cls);
+int           cfg_get_sw_repeat_interval(int cls);
+
+/* Chatter filter: per-key debounce threshold (ms, 0 = off) */
+BOOL          cfg_is_debounce(void);
+int           cfg_get_debounce_ms(int vk);
+void          cfg_set_debounce_keys(const wchar_t *list);
+void          cfg_get_debounce_keys(wchar_t *buf, int size);
 
 /* Priority */
 Priority      cfg_get_priority(void);
@@ -107,7 +141,8 @@ void          cfg_load_properties(BOOL update);
 void          cfg_store_properties(void);
 void          cfg_reload_properties(void);
 void          cfg_set_selected_properties(const wchar_t *name);
-const wchar_t *cfg_get_selected_properties(void);
+const wchar_t *cfg_get_selected_properties(void);   /* UI thread */
+void          cfg_get_selected_properties_path(wchar_t *buf, int bufsize);
 
 /* Properties path helpers */
 void          cfg_get_properties_path(const wchar_t *name, wchar_t *buf, int bufsize);
@@ -125,9 +160,26 @@ typedef void (*VoidCallback)(void);
 typedef void (*SendWheelRawCallback)(int, int);
 
 void          cfg_set_init_scroll_cb(VoidCallback f);
+void          cfg_set_exit_scroll_cb(VoidCallback f);
 void          cfg_set_change_trigger_cb(VoidCallback f);
 void          cfg_set_init_state_meh_cb(VoidCallback f);
 void          cfg_set_init_state_keh_cb(VoidCallback f);
+void          cfg_set_mouse_demand_cb(VoidCallback f);
+void          cfg_set_prepare_scroll_cb(VoidCallback f);
+
+/* Settings generation: changes whenever any setting does */
+LONG          cfg_get_generation(void);
+
+/* Batch several setters into one published snapshot (nestable) */
+void          cfg_begin_update(void);
+void          cfg_end_update(void);
+
+/* Pin the current snapshot for one event on this thread (nestable) */
+void          cfg_read_begin(void);
+void          cfg_read_end(void);
+
+/* Mouse hook demand (trigger, pass mode, active session, pending flags) */
+BOOL          cfg_is_mouse_hook_needed(void);
 
 void          cfg_init_state(void);
 void          cfg_exit_action(void);
@@ -144,6 +196,7 @@ void          cfg_set_boolean(const wchar_t *name, BOOL b);
 void          cfg_set_accel_multiplier_name(const wchar_t *name);
 void          cfg_set_priority_name(const wchar_t *name);
 void          cfg_set_vk_code_name(const wchar_t *name);
+void          cfg_get_vk_code_names(wchar_t *buf, int size);
 void          cfg_set_vh_method_name(const wchar_t *name);
 void          cfg_set_trigger_name(const wchar_t *name);
 
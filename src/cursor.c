@@ -5,6 +5,7 @@
 
 #include "cursor.h"
 #include "types.h"
+#include <process.h>
 
 #ifndef SPI_SETCURSORS
 #define SPI_SETCURSORS 0x0057
@@ -13,25 +14,204 @@
 #define IMAGE_CURSOR   2
 #endif
 
+/*
+ * Cursor swaps run on a worker thread: SetSystemCursor and the copies it
+ * consumes are too slow for scroll start/exit on the hook thread. Callers
+ * only store the wanted state and signal; the worker applies the latest
+ * one, so rapid V/H/restore flips collapse into the final state.
+ */
+#define CURSOR_RESTORED 0
+#define CURSOR_V        1
+#define CURSOR_H        2
+#define CURSOR_SLOTS    3
+
+static const DWORD CURSOR_IDS[CURSOR_SLOTS] = {
+    TPKB_OCR_NORMAL, TPKB_OCR_IBEAM, TPKB_OCR_HAND
+};
+
+/* Value names of the same cursors under HKCU\Control Panel\Cursors */
+static const wchar_t *CURSOR_SCHEME_NAMES[CURSOR_SLOTS] = {
+    L"Arrow", L"IBeam", L"Hand"
+};
+
 static HCURSOR g_cursor_v;
 static HCURSOR g_cursor_h;
 
+/* Worker-owned: copies ready to hand to SetSystemCursor (it takes
+   ownership) */
+static HCURSOR g_ready[3][CURSOR_SLOTS];
+static LONG    g_applied = CURSOR_RESTORED;
+
+/* Worker-owned: the user's cursors, captured when a swap starts and
+   handed back to SetSystemCursor on restore */
+static HCURSOR g_saved[CURSOR_SLOTS];
+
+static volatile LONG g_want = CURSOR_RESTORED;
+static volatile LONG g_quit = FALSE;
+static HANDLE g_wake = NULL;
+static HANDLE g_thread = NULL;
+
+static HCURSOR source_of(LONG state) {
+    return state == CURSOR_V ? g_cursor_v : g_cursor_h;
+}
+
+static void prepare(LONG state) {
+    for (int i = 0; i < CURSOR_SLOTS; i++) {
+        if (!g_ready[state][i])
+            g_ready[state][i] = CopyIcon(source_of(state));
+    }
+}
+
+static void drop_saved(void) {
+    for (int i = 0; i < CURSOR_SLOTS; i++) {
+        if (g_saved[i]) DestroyCursor(g_saved[i]);
+        g_saved[i] = NULL;
+    }
+}
+
+/*
+ * The scheme file for slot i, or NULL when the scheme leaves it at the
+ * Windows default (empty value). LoadCursorFromFileW keeps every frame
+ * of an animated (.ani) cursor, which a CopyIcon capture would lose.
+ */
+static HCURSOR load_scheme_cursor(HKEY key, int i) {
+    wchar_t raw[MAX_PATH], path[MAX_PATH];
+    DWORD type, size = sizeof(raw) - sizeof(wchar_t);
+    if (!key || RegQueryValueExW(key, CURSOR_SCHEME_NAMES[i], NULL, &type,
+                                 (BYTE *)raw, &size) != ERROR_SUCCESS)
+        return NULL;
+    if (type != REG_SZ && type != REG_EXPAND_SZ) return NULL;
+    raw[size / sizeof(wchar_t)] = L'\0';
+    if (!raw[0]) return NULL;
+    DWORD n = ExpandEnvironmentStringsW(raw, path, MAX_PATH);
+    if (n == 0 || n > MAX_PATH) return NULL;
+    return LoadCursorFromFileW(path);
+}
+
+/*
+ * Capture the user's cursors before the first swap. A default (static)
+ * cursor is copied as it is shown now. Returns FALSE when any slot could
+ * not be captured; restore then reloads the whole scheme instead.
+ */
+static BOOL save_scheme(void) {
+    HKEY key = NULL;
+    if (RegOpenKeyExW(HKEY_CURRENT_USER, L"Control Panel\\Cursors", 0,
+                      KEY_QUERY_VALUE, &key) != ERROR_SUCCESS)
+        key = NULL;
+    BOOL ok = TRUE;
+    for (int i = 0; i < CURSOR_SLOTS; i++) {
+        HCURSOR c = load_scheme_cursor(key, i);
+        if (!c) {
+            HCURSOR shown = (HCURSOR)LoadImageW(NULL, MAKEINTRESOURCEW(CURSOR_IDS[i]),
+                                                IMAGE_CURSOR, 0, 0, LR_DEFAULTSIZE | LR_SHARED);
+            c = shown ? CopyIcon(shown) : NULL;
+        }
+        g_saved[i] = c;
+        if (!c) ok = FALSE;
+    }
+    if (key) RegCloseKey(key);
+    if (!ok) drop_saved();
+    return ok;
+}
+
+static void show(LONG state) {
+    if (g_applied == CURSOR_RESTORED) {
+        drop_saved();
+        save_scheme();
+    }
+    prepare(state);
+    for (int i = 0; i < CURSOR_SLOTS; i++) {
+        SetSystemCursor(g_ready[state][i], CURSOR_IDS[i]);
+        g_ready[state][i] = NULL;
+    }
+    prepare(state);
+}
+
+/*
+ * Put back only the three swapped cursors. SPI_SETCURSORS reloads every
+ * system cursor and broadcasts the change, so it is kept for when the
+ * capture failed.
+ */
+static void restore(void) {
+    if (!g_saved[0]) {
+        SystemParametersInfoW(SPI_SETCURSORS, 0, NULL, 0);
+        return;
+    }
+    for (int i = 0; i < CURSOR_SLOTS; i++) {
+        if (!SetSystemCursor(g_saved[i], CURSOR_IDS[i])) {
+            DestroyCursor(g_saved[i]);
+            g_saved[i] = NULL;
+            drop_saved();
+            SystemParametersInfoW(SPI_SETCURSORS, 0, NULL, 0);
+            return;
+        }
+        g_saved[i] = NULL;
+    }
+}
+
+static void apply(LONG state) {
+    if (state == g_applied) return;
+    if (state == CURSOR_RESTORED) restore();
+    else show(state);
+    g_applied = state;
+}
+
+static unsigned __stdcall cursor_thread_proc(void *arg) {
+    (void)arg;
+    prepare(CURSOR_V);
+    prepare(CURSOR_H);
+    for (;;) {
+        WaitForSingleObject(g_wake, INFINITE);
+        apply(InterlockedCompareExchange(&g_want, 0, 0));
+        if (g_quit) break;
+    }
+    return 0;
+}
+
+static void request(LONG state) {
+    InterlockedExchange(&g_want, state);
+    if (g_thread) SetEvent(g_wake);
+    else apply(state);
+}
+
 void cursor_init(void) {
     g_cursor_v = (HCURSOR)LoadImageW(NULL, MAKEINTRESOURCEW(TPKB_OCR_SIZENS),
                                      IMAGE_CURSOR, 0, 0, LR_DEFAULTSIZE | LR_SHARED);
     g_cursor_h = (HCURSOR)LoadImageW(NULL, MAKEINTRESOURCEW(TPKB_OCR_SIZEWE),
                                      IMAGE_CURSOR, 0, 0, LR_DEFAULTSIZE | LR_SHARED);
-}
 
-static void cursor_change(HCURSOR hcur) {
-    SetSystemCursor(CopyIcon(hcur), TPKB_OCR_NORMAL);
-    SetSystemCursor(CopyIcon(hcur), TPKB_OCR_IBEAM);
-    SetSystemCursor(CopyIcon(hcur), TPKB_OCR_HAND);
+    g_wake = CreateEventW(NULL, FALSE, FALSE, NULL);
+    if (!g_wake) return;
+    g_thread = (HANDLE)_beginthreadex(NULL, 0, cursor_thread_proc, NULL, 0, NULL);
+    if (g_thread)
+        SetThreadPriority(g_thread, THREAD_PRIORITY_ABOVE_NORMAL);
 }
 
-void cursor_change_v(void) { cursor_change(g_cursor_v); }
-void cursor_change_h(void) { cursor_change(g_cursor_h); }
-
-void cursor_restore(void) {
-    SystemParametersInfoW(SPI_SETCURSORS, 0, NULL, 0);
+/* Restores the user's cursors before the worker exits */
+void cursor_cleanup(void) {
+    if (g_thread) {
+        InterlockedExchange(&g_want, CURSOR_RESTORED);
+        InterlockedExchange(&g_quit, TRUE);
+        SetEvent(g_wake);
+        WaitForSingleObject(g_thread, 2000);
+        CloseHandle(g_thread);
+        g_thread = NULL;
+    } else {
+        apply(CURSOR_RESTORED);
+    }
+    drop_saved();
+    for (int s = CURSOR_V; s <= CURSOR_H; s++) {
+        for (int i = 0; i < CURSOR_SLOTS; i++) {
+            if (g_ready[s][i]) DestroyCursor(g_ready[s][i]);
+            g_ready[s][i] = NULL;
+        }
+    }
+    if (g_wake) {
+        CloseHandle(g_wake);
+        g_wake = NULL;
+    }
 }
+
+void cursor_change_v(void) { request(CURSOR_V); }
+void cursor_change_h(void) { request(CURSOR_H); }
+void cursor_restore(void) { request(CURSOR_RESTORED); }
@@ -7,6 +7,7 @@
 #define W10WHEEL_CURSOR_H
 
 void cursor_init(void);
+void cursor_cleanup(void);
 void cursor_change_v(void);
 void cursor_change_h(void);
 void cursor_restore(void);
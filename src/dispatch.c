@@ -10,6 +10,8 @@
 #include "event.h"
 #include "kevent.h"
 #include "tray.h"
+#include "keystate.h"
+#include "krepeat.h"
 
 #ifndef _MSC_VER
 #include <setjmp.h>
@@ -19,15 +21,16 @@ static volatile int g_hook_depth = 0;
 
 static LONG CALLBACK dispatch_veh(EXCEPTION_POINTERS *ep) {
     (void)ep;
-    if (g_hook_depth > 0)
+    /* Only unwind faults raised inside a callback on the hook thread */
+    if (g_hook_depth > 0 && hook_is_hook_thread())
         longjmp(g_hook_jmpbuf, 1);
     return EXCEPTION_CONTINUE_SEARCH;
 }
 #endif
 
 /*
- * Hook callbacks are always invoked sequentially on the main thread, so
- * module-level statics are safe to use as "captured" parameters.
+ * Hook callbacks are always invoked sequentially on the hook thread (see
+ * hook.c), so module-level statics are safe to use as "captured" parameters.
  */
 
 static int sm_nCode;
@@ -54,6 +57,8 @@ static LRESULT CALLBACK mouse_proc(int nCode, WPARAM wParam, LPARAM lParam) {
     tray_hook_alive();
 
     const MSLLHOOKSTRUCT *info = (const MSLLHOOKSTRUCT *)lParam;
+    hook_record_delay(info->time);
+    cfg_read_begin();
 
     /* Save/restore statics for re-entrancy (SendInput can re-enter the hook) */
     int prev_nCode = sm_nCode;
@@ -110,6 +115,11 @@ mouse_done:
     sm_nCode = prev_nCode;
     sm_wParam = prev_wParam;
     sm_lParam = prev_lParam;
+
+    /* Last pending mouse up consumed after a keyboard session: drop the hook */
+    if (!cfg_is_mouse_hook_needed())
+        hook_update_mouse();
+    cfg_read_end();
     return result;
 }
 
@@ -119,6 +129,29 @@ static LRESULT CALLBACK keyboard_proc(int nCode, WPARAM wParam, LPARAM lParam) {
         return hook_call_next_keyboard(nCode, wParam, lParam);
 
     const KBDLLHOOKSTRUCT *info = (const KBDLLHOOKSTRUCT *)lParam;
+    hook_record_delay(info->time);
+
+    /* Software repeat: our own repeats pass, OS auto-repeats are dropped */
+    if (krepeat_is_repeat(info))
+        return hook_call_next_keyboard(nCode, wParam, lParam);
+
+    cfg_read_begin();
+    if (kevent_debounce(info)) {
+        /* A dropped up still ends any repeat of its key */
+        if (info->flags & LLKHF_UP) krepeat_filter(info);
+        cfg_read_end();
+        return 1;
+    }
+    keystate_update((int)info->vkCode, !(info->flags & LLKHF_UP));
+    if (krepeat_filter(info)) {
+        cfg_read_end();
+        return 1;
+    }
+    /* Hook installed for repeat/debounce only: no trigger keys */
+    if (!cfg_is_keyboard_hook()) {
+        cfg_read_end();
+        return hook_call_next_keyboard(nCode, wParam, lParam);
+    }
 
     /* Save/restore statics for re-entrancy (SendInput can re-enter the hook) */
     int prev_nCode = sk_nCode;
@@ -168,6 +201,7 @@ keyboard_done:
     sk_nCode = prev_nCode;
     sk_wParam = prev_wParam;
     sk_lParam = prev_lParam;
+    cfg_read_end();
     return result;
 }
 
@@ -177,4 +211,6 @@ void dispatch_init(void) {
 #endif
     hook_set_mouse_dispatcher(mouse_proc);
     hook_set_keyboard_dispatcher(keyboard_proc);
+    hook_set_mouse_demand(cfg_is_mouse_hook_needed);
+    cfg_set_mouse_demand_cb(hook_update_mouse);
 }
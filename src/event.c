@@ -33,10 +33,8 @@ static MouseEvent g_last_resend_right = { ME_NON_EVENT };
 static BOOL g_resent_down_up = FALSE;
 static BOOL g_second_trigger_up = FALSE;
 
-/* Drag state */
+/* Drag state (dragged / pre-scroll flags live in the cfg state word) */
 static void (*g_drag_fn)(const MSLLHOOKSTRUCT *) = NULL;
-static BOOL g_dragged = FALSE;
-static BOOL g_drag_pre_scroll = FALSE;
 static int g_drag_start_x, g_drag_start_y;
 static int g_drag_move_x, g_drag_move_y;
 
@@ -49,8 +47,7 @@ static void init_state(void) {
     g_resent_down_up = FALSE;
     g_second_trigger_up = FALSE;
     g_drag_fn = drag_default;
-    g_dragged = FALSE;
-    g_drag_pre_scroll = FALSE;
+    cfg_update_state(RS_DRAG_PRE_SCROLL | RS_DRAGGED, 0);
     g_drag_start_x = 0; g_drag_start_y = 0;
     g_drag_move_x = 0; g_drag_move_y = 0;
 }
@@ -86,8 +83,8 @@ static LRESULT skip_resend_lr(const MouseEvent *me) {
                 if (lr) *lr = *me;
                 return call_next_hook();
             } else {
-                Sleep(1);
-                scroll_resend_up(me);
+                /* Up overtook its down: re-send it behind the down */
+                scroll_resend_up_delayed(me, 1);
                 return HOOK_SUPPRESS;
             }
         }
@@ -179,11 +176,11 @@ static LRESULT check_exit_scroll_up_lr(const MouseEvent *me) {
 static LRESULT check_starting_scroll(const MouseEvent *me) {
     (void)me;
     if (cfg_is_starting_scroll()) {
-        Sleep(1);
         if (!g_second_trigger_up) {
             /* Ignore first up (starting) */
         } else {
-            cfg_exit_scroll();
+            /* Waiter may not have committed the start yet: defer, don't sleep */
+            cfg_exit_scroll_deferred();
         }
         g_second_trigger_up = !g_second_trigger_up;
         return HOOK_SUPPRESS;
@@ -220,6 +217,7 @@ static LRESULT check_passed_down(const MouseEvent *me) {
 
 static LRESULT check_trigger_wait_start(const MouseEvent *me) {
     if (cfg_is_lr_trigger() || cfg_is_trigger_event(me->type)) {
+        cfg_prepare_scroll();
         if (waiter_start(me))
             return HOOK_SUPPRESS;
     }
@@ -280,28 +278,27 @@ static void drag_start(const MSLLHOOKSTRUCT *info) {
     int thr = cfg_get_drag_threshold();
     if (g_drag_move_x > thr || g_drag_move_y > thr) {
         cfg_start_scroll(info);
-        g_drag_pre_scroll = FALSE;
+        cfg_update_state(RS_DRAG_PRE_SCROLL, RS_DRAGGED);
         if (cfg_is_cursor_change() && !cfg_is_vh_adjuster_mode())
             cursor_change_v();
         g_drag_fn = drag_default;
-        g_dragged = TRUE;
     }
 }
 
 static LRESULT start_scroll_drag(const MouseEvent *me) {
-    g_drag_pre_scroll = TRUE;
     g_drag_start_x = me->info.pt.x;
     g_drag_start_y = me->info.pt.y;
     g_drag_move_x = 0;
     g_drag_move_y = 0;
     g_drag_fn = drag_start;
-    g_dragged = FALSE;
+    cfg_prepare_scroll();
+    cfg_update_state(RS_DRAGGED, RS_DRAG_PRE_SCROLL);
     return HOOK_SUPPRESS;
 }
 
 static LRESULT continue_scroll_drag(const MouseEvent *me) {
     (void)me;
-    if (cfg_is_dragged_lock() && g_dragged) {
+    if (cfg_is_dragged_lock() && (cfg_get_state() & RS_DRAGGED)) {
         cfg_set_released_scroll();
         return HOOK_SUPPRESS;
     }
@@ -310,10 +307,10 @@ static LRESULT continue_scroll_drag(const MouseEvent *me) {
 
 static LRESULT exit_and_resend_drag(const MouseEvent *me) {
     g_drag_fn = drag_default;
-    g_drag_pre_scroll = FALSE;
+    LONG st = cfg_update_state(RS_DRAG_PRE_SCROLL, 0);
     cfg_exit_scroll();
 
-    if (!g_dragged) {
+    if (!(st & RS_DRAGGED)) {
         MouseClickType mc;
         switch (me->type) {
         case ME_LEFT_UP:   mc = MC_LEFT;   break;
@@ -518,7 +515,7 @@ LRESULT event_x_up(const MSLLHOOKSTRUCT *info) {
 }
 
 LRESULT event_move(const MSLLHOOKSTRUCT *info) {
-    if (cfg_is_scroll_mode() || g_drag_pre_scroll) {
+    if (cfg_get_state() & (RS_SCROLL_MODE | RS_DRAG_PRE_SCROLL)) {
         if (g_drag_fn) g_drag_fn(info);
         return HOOK_SUPPRESS;
     }
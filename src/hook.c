@@ -7,6 +7,9 @@
 #include "types.h"
 #include "dialog.h"
 #include "util.h"
+#include "keystate.h"
+#include "krepeat.h"
+#include <process.h>
 
 static volatile HHOOK g_mouse_hhk = NULL;
 static volatile HHOOK g_keyboard_hhk = NULL;
@@ -14,6 +17,34 @@ static volatile HHOOK g_keyboard_hhk = NULL;
 static LowLevelMouseProc g_mouse_dispatcher = NULL;
 static LowLevelKeyboardProc g_keyboard_dispatcher = NULL;
 
+/*
+ * Hooks are installed from a dedicated thread so their callbacks are never
+ * queued behind the tray menu, the modal settings dialog or blocking
+ * SystemParametersInfo broadcasts on the UI thread. Other threads marshal
+ * install/uninstall requests to it and wait for the result.
+ */
+#define WM_HOOK_SET_MOUSE       (WM_APP + 1)
+#define WM_HOOK_SET_KEYBOARD    (WM_APP + 2)
+#define WM_HOOK_UNHOOK_MOUSE    (WM_APP + 3)
+#define WM_HOOK_UNHOOK_KEYBOARD (WM_APP + 4)
+#define WM_HOOK_UPDATE_MOUSE    (WM_APP + 5)
+
+typedef struct {
+    HANDLE done;
+    BOOL   ok;
+    DWORD  err;
+} HookRequest;
+
+static HANDLE g_hook_thread = NULL;
+static volatile DWORD g_hook_tid = 0;
+
+/* Mouse hook demand: installed only while the predicate holds */
+static BOOL (*g_mouse_needed_fn)(void) = NULL;
+static volatile LONG g_mouse_update_posted = FALSE;
+
+/* Queueing delay: time from the input event to our callback */
+static LatencyStat g_hook_delay;
+
 void hook_set_mouse_dispatcher(LowLevelMouseProc proc) {
     g_mouse_dispatcher = proc;
 }
@@ -32,28 +63,153 @@ LRESULT hook_call_next_keyboard(int nCode, WPARAM wParam, LPARAM lParam) {
     return CallNextHookEx(hhk, nCode, wParam, lParam);
 }
 
-BOOL hook_set_mouse(void) {
+/* ========== Hook thread (install/uninstall run here) ========== */
+
+static BOOL set_mouse_local(void) {
     HINSTANCE hmod = GetModuleHandleW(NULL);
     HHOOK hhk = SetWindowsHookExW(WH_MOUSE_LL, g_mouse_dispatcher, hmod, 0);
     InterlockedExchangePointer((volatile PVOID *)&g_mouse_hhk, hhk);
     return hhk != NULL;
 }
 
-BOOL hook_set_keyboard(void) {
+static BOOL set_keyboard_local(void) {
     HINSTANCE hmod = GetModuleHandleW(NULL);
     HHOOK hhk = SetWindowsHookExW(WH_KEYBOARD_LL, g_keyboard_dispatcher, hmod, 0);
     InterlockedExchangePointer((volatile PVOID *)&g_keyboard_hhk, hhk);
+    if (hhk) keystate_use_hook(TRUE);
     return hhk != NULL;
 }
 
-void hook_unhook_mouse(void) {
+static BOOL unhook_mouse_local(void) {
     HHOOK hhk = (HHOOK)InterlockedExchangePointer((volatile PVOID *)&g_mouse_hhk, NULL);
     if (hhk) UnhookWindowsHookEx(hhk);
+    return TRUE;
 }
 
-void hook_unhook_keyboard(void) {
+static BOOL unhook_keyboard_local(void) {
     HHOOK hhk = (HHOOK)InterlockedExchangePointer((volatile PVOID *)&g_keyboard_hhk, NULL);
-    if (hhk) UnhookWindowsHookEx(hhk);
+    if (hhk) {
+        UnhookWindowsHookEx(hhk);
+        keystate_use_hook(FALSE);
+        krepeat_reset();
+    }
+    return TRUE;
+}
+
+/* Evaluated on the hook thread, so the latest state always wins */
+static void update_mouse_local(void) {
+    InterlockedExchange(&g_mouse_update_posted, FALSE);
+    BOOL need = g_mouse_needed_fn ? g_mouse_needed_fn() : TRUE;
+    BOOL set = InterlockedCompareExchangePointer((volatile PVOID *)&g_mouse_hhk, NULL, NULL) != NULL;
+    if (need && !set) set_mouse_local();
+    else if (!need && set) unhook_mouse_local();
+}
+
+static BOOL run_local(UINT msg) {
+    switch (msg) {
+    case WM_HOOK_SET_MOUSE:       return set_mouse_local();
+    case WM_HOOK_SET_KEYBOARD:    return set_keyboard_local();
+    case WM_HOOK_UNHOOK_MOUSE:    return unhook_mouse_local();
+    case WM_HOOK_UNHOOK_KEYBOARD: return unhook_keyboard_local();
+    default:                      return FALSE;
+    }
+}
+
+static unsigned __stdcall hook_thread_proc(void *arg) {
+    HANDLE ready = (HANDLE)arg;
+    MSG msg;
+
+    /* Force creation of the message queue before signalling readiness */
+    PeekMessageW(&msg, NULL, WM_USER, WM_USER, PM_NOREMOVE);
+    g_hook_tid = GetCurrentThreadId();
+    SetEvent(ready);
+
+    while (GetMessageW(&msg, NULL, 0, 0) > 0) {
+        if (msg.hwnd == NULL && msg.message == WM_HOOK_UPDATE_MOUSE) {
+            update_mouse_local();
+            continue;
+        }
+        if (msg.hwnd == NULL && msg.message >= WM_HOOK_SET_MOUSE &&
+            msg.message <= WM_HOOK_UNHOOK_KEYBOARD) {
+            HookRequest *req = (HookRequest *)msg.lParam;
+            req->ok = run_local(msg.message);
+            req->err = GetLastError();
+            SetEvent(req->done);
+            continue;
+        }
+        TranslateMessage(&msg);
+        DispatchMessageW(&msg);
+    }
+
+    unhook_mouse_local();
+    unhook_keyboard_local();
+    return 0;
+}
+
+/* Run a request on the hook thread and wait; falls back to the caller */
+static BOOL hook_request(UINT msg) {
+    DWORD tid = g_hook_tid;
+    if (tid == 0 || tid == GetCurrentThreadId())
+        return run_local(msg);
+
+    HookRequest req = { CreateEventW(NULL, FALSE, FALSE, NULL), FALSE, 0 };
+    if (!req.done)
+        return run_local(msg);
+
+    if (!PostThreadMessageW(tid, msg, 0, (LPARAM)&req)) {
+        CloseHandle(req.done);
+        return run_local(msg);
+    }
+    WaitForSingleObject(req.done, INFINITE);
+    CloseHandle(req.done);
+    SetLastError(req.err);
+    return req.ok;
+}
+
+BOOL hook_thread_start(void) {
+    HANDLE ready = CreateEventW(NULL, TRUE, FALSE, NULL);
+    if (!ready) return FALSE;
+
+    g_hook_thread = (HANDLE)_beginthreadex(NULL, 0, hook_thread_proc, ready, 0, NULL);
+    if (!g_hook_thread) {
+        CloseHandle(ready);
+        return FALSE;
+    }
+    SetThreadPriority(g_hook_thread, THREAD_PRIORITY_HIGHEST);
+    WaitForSingleObject(ready, INFINITE);
+    CloseHandle(ready);
+    return TRUE;
+}
+
+void hook_thread_stop(void) {
+    if (!g_hook_thread) return;
+    PostThreadMessageW(g_hook_tid, WM_QUIT, 0, 0);
+    WaitForSingleObject(g_hook_thread, 2000);
+    CloseHandle(g_hook_thread);
+    g_hook_thread = NULL;
+    g_hook_tid = 0;
+}
+
+BOOL hook_is_hook_thread(void) {
+    return g_hook_tid == GetCurrentThreadId();
+}
+
+/* ========== Public install/uninstall ========== */
+
+BOOL hook_set_mouse(void) {
+    return hook_request(WM_HOOK_SET_MOUSE);
+}
+
+BOOL hook_set_keyboard(void) {
+    return hook_request(WM_HOOK_SET_KEYBOARD);
+}
+
+void hook_unhook_mouse(void) {
+    hook_request(WM_HOOK_UNHOOK_MOUSE);
+}
+
+void hook_unhook_keyboard(void) {
+    hook_request(WM_HOOK_UNHOOK_KEYBOARD);
 }
 
 void hook_set_or_unset_keyboard(BOOL enable) {
@@ -67,7 +223,40 @@ void hook_set_or_unset_keyboard(BOOL enable) {
     }
 }
 
+/* ========== Demand-driven mouse hook ========== */
+
+void hook_set_mouse_demand(BOOL (*needed)(void)) {
+    g_mouse_needed_fn = needed;
+}
+
+/* Asynchronous; safe from inside a hook callback. Coalesces repeats. */
+void hook_update_mouse(void) {
+    DWORD tid = g_hook_tid;
+    if (tid == 0) return;
+    if (InterlockedExchange(&g_mouse_update_posted, TRUE)) return;
+    if (!PostThreadMessageW(tid, WM_HOOK_UPDATE_MOUSE, 0, 0))
+        InterlockedExchange(&g_mouse_update_posted, FALSE);
+}
+
+BOOL hook_is_mouse_set(void) {
+    return InterlockedCompareExchangePointer((volatile PVOID *)&g_mouse_hhk, NULL, NULL) != NULL;
+}
+
 void hook_unhook(void) {
     hook_unhook_mouse();
     hook_unhook_keyboard();
 }
+
+/* ========== Callback delay instrumentation ========== */
+
+void hook_record_delay(DWORD event_time) {
+    util_stat_add(&g_hook_delay, (LONG)(GetTickCount() - event_time));
+}
+
+void hook_delay_reset(void) {
+    util_stat_reset(&g_hook_delay);
+}
+
+void hook_delay_report(const wchar_t *label) {
+    util_stat_report(&g_hook_delay, label, L"ms");
+}
@@ -14,6 +14,11 @@ typedef LRESULT (CALLBACK *LowLevelKeyboardProc)(int, WPARAM, LPARAM);
 void hook_set_mouse_dispatcher(LowLevelMouseProc proc);
 void hook_set_keyboard_dispatcher(LowLevelKeyboardProc proc);
 
+/* Dedicated hook thread; install/uninstall calls are marshalled to it */
+BOOL hook_thread_start(void);
+void hook_thread_stop(void);
+BOOL hook_is_hook_thread(void);
+
 BOOL hook_set_mouse(void);
 BOOL hook_set_keyboard(void);
 void hook_unhook_mouse(void);
@@ -21,7 +26,17 @@ void hook_unhook_keyboard(void);
 void hook_set_or_unset_keyboard(BOOL enable);
 void hook_unhook(void);
 
+/* Install the mouse hook only while needed() is TRUE (checked on update) */
+void hook_set_mouse_demand(BOOL (*needed)(void));
+void hook_update_mouse(void);
+BOOL hook_is_mouse_set(void);
+
 LRESULT hook_call_next_mouse(int nCode, WPARAM wParam, LPARAM lParam);
 LRESULT hook_call_next_keyboard(int nCode, WPARAM wParam, LPARAM lParam);
 
+/* Callback queueing delay (event time to callback), debug output only */
+void hook_record_delay(DWORD event_time);
+void hook_delay_reset(void);
+void hook_delay_report(const wchar_t *label);
+
 #endif
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2026 Li Ruijie
+ * Licensed under the GNU General Public License v3.0.
+ */
+
+#include "iniparse.h"
+#include <string.h>
+
+static int is_blank(char c) { return c == ' ' || c == '\t'; }
+
+void ini_parse(const char *p, const char *end, IniKeyFn fn, void *ctx) {
+    const char *section = NULL;
+    int section_len = 0;
+
+    /* UTF-8 byte order mark */
+    if (end - p >= 3 && (unsigned char)p[0] == 0xEF &&
+        (unsigned char)p[1] == 0xBB && (unsigned char)p[2] == 0xBF)
+        p += 3;
+
+    while (p < end) {
+        const char *eol = memchr(p, '\n', (size_t)(end - p));
+        if (!eol) eol = end;
+        const char *next = eol < end ? eol + 1 : end;
+        const char *le = eol;
+        if (le > p && le[-1] == '\r') le--;
+
+        while (p < le && is_blank(*p)) p++;
+        if (p == le || *p == '#' || *p == ';') { p = next; continue; }
+
+        /* Section header */
+        if (*p == '[') {
+            const char *close = memchr(p, ']', (size_t)(le - p));
+            if (close) {
+                section = p + 1;
+                section_len = (int)(close - section);
+            }
+            p = next;
+            continue;
+        }
+
+        /* Need a current section */
+        if (!section_len) { p = next; continue; }
+
+        /* Split on '=' */
+        const char *eq = memchr(p, '=', (size_t)(le - p));
+        if (!eq) { p = next; continue; }
+
+        const char *k = p, *ke = eq;
+        while (ke > k && is_blank(ke[-1])) ke--;
+        const char *v = eq + 1, *ve = le;
+        while (v < ve && is_blank(*v)) v++;
+        while (ve > v && is_blank(ve[-1])) ve--;
+
+        if (ke > k && ve > v)
+            fn(ctx, section, section_len, k, (int)(ke - k), v, (int)(ve - v));
+        p = next;
+    }
+}
+
+int ini_utf8_prefix(const char *s, int len, int max) {
+    if (len <= max) return len;
+    /* s[max] is the first byte cut off: back up while it continues a sequence */
+    while (max > 0 && ((unsigned char)s[max] & 0xC0) == 0x80) max--;
+    return max;
+}
@@ -0,0 +1,31 @@
+/*
+ * Copyright (c) 2026 Li Ruijie
+ * Licensed under the GNU General Public License v3.0.
+ */
+
+#ifndef W10WHEEL_INIPARSE_H
+#define W10WHEEL_INIPARSE_H
+
+/*
+ * One-pass INI tokenizer over a whole UTF-8 buffer (the mapped settings
+ * file). Sections, keys and values are reported as spans into the
+ * buffer; nothing is copied or allocated. No Windows dependency, so it
+ * builds and fuzzes on any host.
+ *
+ * Rules: a leading UTF-8 BOM is skipped; LF or CRLF ends a line; blanks
+ * (space, tab) around keys and values are trimmed; lines starting with
+ * '#' or ';' are comments; "[name]" opens a section. Key lines before the
+ * first section, without '=', or with an empty key or value are skipped.
+ */
+
+/* sec/key/val point into the parsed buffer and are not terminated */
+typedef void (*IniKeyFn)(void *ctx, const char *sec, int sec_len,
+                         const char *key, int key_len,
+                         const char *val, int val_len);
+
+void ini_parse(const char *p, const char *end, IniKeyFn fn, void *ctx);
+
+/* Longest prefix of s[0..len) of at most max bytes not splitting a UTF-8 sequence */
+int  ini_utf8_prefix(const char *s, int len, int max);
+
+#endif
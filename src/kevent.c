@@ -5,6 +5,9 @@
 
 #include "kevent.h"
 #include "config.h"
+#include "vkcode.h"
+#include "chatter.h"
+#include <stdio.h>
 
 #define CHECK_NEXT    (-1)
 #define HOOK_SUPPRESS 1
@@ -44,6 +47,16 @@ static LRESULT check_same_last(const KeyboardEvent *ke) {
 
 static LRESULT check_trigger_scroll_start(const KeyboardEvent *ke) {
     if (cfg_is_trigger_key(ke)) {
+        /*
+         * A session is already live: don't restart it. Another trigger
+         * key is swallowed along with its up; the starting key's own
+         * repeat must keep its up for check_exit_scroll_up.
+         */
+        if (cfg_is_scroll_mode()) {
+            if ((ke_vk_code(ke) & 0xFF) != cfg_get_scroll_key())
+                cfg_last_flags_set_suppressed_k(ke);
+            return HOOK_SUPPRESS;
+        }
         cfg_start_scroll_k(&ke->info);
         return HOOK_SUPPRESS;
     }
@@ -137,9 +150,59 @@ static LRESULT none_up(const KeyboardEvent *ke) {
     return run_checkers(cs, sizeof(cs)/sizeof(cs[0]), ke);
 }
 
+/* ========== Chatter filter ========== */
+
+/* Release times and the chattered set are touched only on the hook thread */
+static ChatterFilter g_chatter;
+static volatile LONG g_chatter_count[256];
+
+BOOL kevent_debounce(const KBDLLHOOKSTRUCT *info) {
+    if (info->flags & LLKHF_INJECTED) return FALSE;
+    int vk = (int)(info->vkCode & 0xFF);
+    BOOL up = (info->flags & LLKHF_UP) != 0;
+    int ms = (up || cfg_is_pass_mode()) ? 0 : cfg_get_debounce_ms(vk);
+
+    switch (chatter_filter(&g_chatter, vk, up, info->time, ms)) {
+    case CHATTER_BOUNCE:
+        InterlockedIncrement(&g_chatter_count[vk]);
+        return TRUE;
+    case CHATTER_DROP:
+        return TRUE;
+    default:
+        return FALSE;
+    }
+}
+
+LONG kevent_chatter_total(void) {
+    LONG total = 0;
+    for (int vk = 0; vk < 256; vk++)
+        total += g_chatter_count[vk];
+    return total;
+}
+
+void kevent_chatter_report(void) {
+    for (int vk = 1; vk < 256; vk++) {
+        LONG n = g_chatter_count[vk];
+        if (n == 0) continue;
+        wchar_t name[32], buf[96];
+        vk_format_name(vk, name, 32);
+        _snwprintf(buf, 96, L"tpkb: chatter suppressed: %s: %ld\n", name, (long)n);
+        buf[95] = L'\0';
+        OutputDebugStringW(buf);
+    }
+}
+
 /* ========== Public dispatch ========== */
 
+/*
+ * Fast path: a non-trigger key is handed straight back to CallNextHookEx
+ * unless a released scroll is waiting for any key (down) or the key's down
+ * was suppressed (up).
+ */
 LRESULT kevent_key_down(const KBDLLHOOKSTRUCT *info) {
+    if (!cfg_is_trigger_vk(info->vkCode & 0xFF) && !cfg_is_released_scroll())
+        return call_next_hook();
+
     KeyboardEvent ke = { KE_KEY_DOWN, *info };
     if (cfg_is_trigger_key(&ke)) return single_down(&ke);
     return none_down(&ke);
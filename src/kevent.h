@@ -14,4 +14,9 @@ void kevent_set_call_next_hook(LRESULT (*fn)(void));
 LRESULT kevent_key_down(const KBDLLHOOKSTRUCT *info);
 LRESULT kevent_key_up(const KBDLLHOOKSTRUCT *info);
 
+/* Chatter filter: TRUE if the event is contact bounce to suppress */
+BOOL kevent_debounce(const KBDLLHOOKSTRUCT *info);
+LONG kevent_chatter_total(void);
+void kevent_chatter_report(void);
+
 #endif
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2026 Li Ruijie
+ * Licensed under the GNU General Public License v3.0.
+ */
+
+#include "keystate.h"
+#include "rawinput.h"
+
+/*
+ * Modifier and Escape state kept from the input stream itself, so hook
+ * callbacks test it with one load instead of a GetAsyncKeyState syscall
+ * per key.
+ */
+static volatile LONG g_keys = 0;
+static volatile LONG g_from_hook = FALSE;
+
+static const struct { int vk; LONG bit; } KEY_BITS[] = {
+    { VK_LSHIFT,   KS_LSHIFT },
+    { VK_RSHIFT,   KS_RSHIFT },
+    { VK_LCONTROL, KS_LCTRL },
+    { VK_RCONTROL, KS_RCTRL },
+    { VK_LMENU,    KS_LALT },
+    { VK_RMENU,    KS_RALT },
+    { VK_ESCAPE,   KS_ESC },
+};
+#define KEY_BITS_COUNT (sizeof(KEY_BITS) / sizeof(KEY_BITS[0]))
+
+static LONG vk_to_bit(int vk) {
+    for (int i = 0; i < (int)KEY_BITS_COUNT; i++)
+        if (KEY_BITS[i].vk == vk) return KEY_BITS[i].bit;
+    return 0;
+}
+
+static void apply(LONG bit, BOOL down) {
+    if (!bit) return;
+    if (down) InterlockedOr(&g_keys, bit);
+    else      InterlockedAnd(&g_keys, ~bit);
+}
+
+/* Re-read the physical state; used only when the source changes */
+static void resync(void) {
+    LONG keys = 0;
+    for (int i = 0; i < (int)KEY_BITS_COUNT; i++)
+        if (GetAsyncKeyState(KEY_BITS[i].vk) & 0x8000)
+            keys |= KEY_BITS[i].bit;
+    InterlockedExchange(&g_keys, keys);
+}
+
+/* Raw input reports generic VK codes; split into left/right */
+static void on_raw_key(USHORT vkey, USHORT make, USHORT flags) {
+    if (g_from_hook) return;
+
+    int vk = vkey;
+    BOOL e0 = (flags & RI_KEY_E0) != 0;
+    switch (vk) {
+    case VK_SHIFT:   vk = (make == 0x36) ? VK_RSHIFT : VK_LSHIFT; break;
+    case VK_CONTROL: vk = e0 ? VK_RCONTROL : VK_LCONTROL; break;
+    case VK_MENU:    vk = e0 ? VK_RMENU : VK_LMENU; break;
+    default: break;
+    }
+    apply(vk_to_bit(vk), (flags & RI_KEY_BREAK) == 0);
+}
+
+void keystate_update(int vk, BOOL down) {
+    apply(vk_to_bit(vk), down);
+}
+
+LONG keystate_get(void) { return g_keys; }
+
+void keystate_use_hook(BOOL on) {
+    InterlockedExchange(&g_from_hook, on);
+    if (on) rawinput_unregister_keyboard();
+    else    rawinput_register_keyboard();
+    resync();
+}
+
+void keystate_init(void) {
+    rawinput_set_key_raw(on_raw_key);
+    keystate_use_hook(FALSE);
+}
@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2026 Li Ruijie
+ * Licensed under the GNU General Public License v3.0.
+ */
+
+#ifndef W10WHEEL_KEYSTATE_H
+#define W10WHEEL_KEYSTATE_H
+
+#include <windows.h>
+
+/* Modifier / Escape bits */
+#define KS_LSHIFT   0x01
+#define KS_RSHIFT   0x02
+#define KS_LCTRL    0x04
+#define KS_RCTRL    0x08
+#define KS_LALT     0x10
+#define KS_RALT     0x20
+#define KS_ESC      0x40
+
+#define KS_SHIFT    (KS_LSHIFT | KS_RSHIFT)
+#define KS_CTRL     (KS_LCTRL | KS_RCTRL)
+#define KS_ALT      (KS_LALT | KS_RALT)
+
+void keystate_init(void);
+
+/* Source: keyboard hook when installed, keyboard raw input otherwise */
+void keystate_use_hook(BOOL on);
+
+/* Keyboard hook feed (left/right specific VK codes) */
+void keystate_update(int vk, BOOL down);
+
+LONG keystate_get(void);
+
+#endif
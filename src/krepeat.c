@@ -0,0 +1,239 @@
+/*
+ * Copyright (c) 2026 Li Ruijie
+ * Licensed under the GNU General Public License v3.0.
+ */
+
+#include "krepeat.h"
+#include "config.h"
+#include "repeatsched.h"
+#include "util.h"
+#include <process.h>
+
+static const DWORD g_repeat_tag = 0x57314B52; /* ASCII "W1KR" */
+
+/* Physically held keys; touched only on the hook thread */
+static DWORD g_held[8];
+
+/*
+ * Armed key, published by the hook thread:
+ * vk | scan << 8 | extended << 16 | generation << 24 (0 = none).
+ * The generation makes a re-press of the same key restart its delay.
+ */
+static volatile LONG g_active = 0;
+static volatile LONG64 g_armed_qpc = 0;
+static LONG g_generation = 0;
+
+static LONGLONG g_qpf = 1;
+static HANDLE g_wake = NULL;
+static HANDLE g_timer = NULL;
+static HANDLE g_repeat_thread = NULL;
+static volatile BOOL g_repeat_running = FALSE;
+
+/* Actual fire time minus deadline */
+static LatencyStat g_lateness;
+
+/* ========== Key classes ========== */
+
+static BOOL is_excluded(int vk) {
+    switch (vk) {
+    case VK_SHIFT: case VK_LSHIFT: case VK_RSHIFT:
+    case VK_CONTROL: case VK_LCONTROL: case VK_RCONTROL:
+    case VK_MENU: case VK_LMENU: case VK_RMENU:
+    case VK_LWIN: case VK_RWIN:
+    case VK_CAPITAL: case VK_NUMLOCK: case VK_SCROLL:
+        return TRUE;
+    default:
+        return cfg_is_keyboard_hook() && cfg_is_trigger_vk(vk);
+    }
+}
+
+static int key_class(int vk) {
+    switch (vk) {
+    case VK_LEFT: case VK_RIGHT: case VK_UP: case VK_DOWN:
+    case VK_PRIOR: case VK_NEXT: case VK_HOME: case VK_END:
+        return KR_CLASS_NAV;
+    case VK_BACK: case VK_DELETE:
+        return KR_CLASS_EDIT;
+    default:
+        return KR_CLASS_DEFAULT;
+    }
+}
+
+/* ========== Hook side ========== */
+
+BOOL krepeat_is_repeat(const KBDLLHOOKSTRUCT *info) {
+    return (DWORD)info->dwExtraInfo == g_repeat_tag;
+}
+
+static void arm(const KBDLLHOOKSTRUCT *info) {
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    g_generation = (g_generation + 1) & 0x7F;
+    if (g_generation == 0) g_generation = 1;
+    InterlockedExchange64(&g_armed_qpc, now.QuadPart);
+    InterlockedExchange(&g_active, (LONG)((info->vkCode & 0xFF) |
+        ((info->scanCode & 0xFF) << 8) |
+        ((info->flags & LLKHF_EXTENDED) ? 0x10000 : 0) |
+        (g_generation << 24)));
+    SetEvent(g_wake);
+}
+
+static void disarm(void) {
+    if (InterlockedExchange(&g_active, 0) != 0 && g_wake)
+        SetEvent(g_wake);
+}
+
+void krepeat_cancel(void) {
+    disarm();
+}
+
+void krepeat_reset(void) {
+    ZeroMemory(g_held, sizeof(g_held));
+    disarm();
+}
+
+static BOOL is_down(int vk) {
+    return (GetAsyncKeyState(vk) & 0x8000) != 0;
+}
+
+BOOL krepeat_filter(const KBDLLHOOKSTRUCT *info) {
+    int vk = (int)(info->vkCode & 0xFF);
+    DWORD bit = 1u << (vk & 31);
+    BOOL held = (g_held[vk >> 5] & bit) != 0;
+
+    /*
+     * The async state does not include this event yet. An OS repeat finds
+     * the key down; finding it up means its last up never reached us
+     * (hook timeout), so this is a fresh press.
+     */
+    if (held && !(info->flags & LLKHF_UP) && !is_down(vk))
+        held = FALSE;
+
+    if (info->flags & LLKHF_UP) {
+        g_held[vk >> 5] &= ~bit;
+        if ((g_active & 0xFF) == vk) disarm();
+        return FALSE;
+    }
+    g_held[vk >> 5] |= bit;
+
+    if (!cfg_is_sw_repeat() ||
+        (cfg_get_state() & (RS_PASS_MODE | RS_SCROLL_MODE | RS_SCROLL_STARTING))) {
+        disarm();
+        return FALSE;
+    }
+    if (is_excluded(vk)) {
+        /* The OS repeats only the last key pressed; follow it */
+        if (!held) disarm();
+        return FALSE;
+    }
+    if (held) return TRUE;
+    arm(info);
+    return FALSE;
+}
+
+/* ========== Timer thread ========== */
+
+static void send_repeat(LONG key) {
+    INPUT inp;
+    ZeroMemory(&inp, sizeof(inp));
+    inp.type = INPUT_KEYBOARD;
+    inp.ki.wVk = (WORD)(key & 0xFF);
+    inp.ki.wScan = (WORD)((key >> 8) & 0xFF);
+    inp.ki.dwFlags = (key & 0x10000) ? KEYEVENTF_EXTENDEDKEY : 0;
+    inp.ki.dwExtraInfo = (ULONG_PTR)g_repeat_tag;
+    SendInput(1, &inp, sizeof(INPUT));
+}
+
+static LONGLONG ms_to_qpc(int ms) {
+    return (LONGLONG)ms * g_qpf / 1000;
+}
+
+/* Deadlines in QPC ticks; the schedule itself is in repeatsched.h */
+static unsigned __stdcall repeat_proc(void *arg) {
+    (void)arg;
+    HANDLE waits[2] = { g_wake, g_timer };
+    LONG cur = 0;
+    RepeatSchedule sched = { 0, 1 };
+
+    while (g_repeat_running) {
+        LONG key = g_active;
+        if (key != cur) {
+            cur = key;
+            if (cur) {
+                int cls = key_class(cur & 0xFF);
+                cfg_read_begin();
+                repeat_sched_start(&sched, g_armed_qpc,
+                                   ms_to_qpc(cfg_get_sw_repeat_delay(cls)),
+                                   ms_to_qpc(cfg_get_sw_repeat_interval(cls)));
+                cfg_read_end();
+            }
+        }
+        if (!cur) {
+            WaitForSingleObject(g_wake, INFINITE);
+            continue;
+        }
+
+        LARGE_INTEGER now;
+        QueryPerformanceCounter(&now);
+        LONGLONG remain = sched.next - now.QuadPart;
+        if (remain > 0) {
+            /* Relative due time in 100 ns units */
+            LARGE_INTEGER due;
+            due.QuadPart = -(remain * 10000000 / g_qpf);
+            if (due.QuadPart == 0) due.QuadPart = -1;
+            SetWaitableTimer(g_timer, &due, 0, NULL, NULL, FALSE);
+            if (WaitForMultipleObjects(2, waits, FALSE, INFINITE) == WAIT_OBJECT_0) {
+                CancelWaitableTimer(g_timer);
+                continue;
+            }
+            QueryPerformanceCounter(&now);
+        }
+        if (g_active != cur) continue;
+
+        /* Never outlive the key: its up may have been lost or dropped */
+        cfg_read_begin();
+        BOOL enabled = cfg_is_sw_repeat();
+        cfg_read_end();
+        if (!enabled || !is_down(cur & 0xFF)) {
+            InterlockedCompareExchange(&g_active, 0, cur);
+            continue;
+        }
+
+        util_stat_add(&g_lateness, (LONG)((now.QuadPart - sched.next) * 1000000 / g_qpf));
+        send_repeat(cur);
+        repeat_sched_fired(&sched, now.QuadPart);
+    }
+    return 0;
+}
+
+/* ========== Init / cleanup ========== */
+
+void krepeat_init(void) {
+    LARGE_INTEGER f;
+    QueryPerformanceFrequency(&f);
+    g_qpf = f.QuadPart;
+
+    g_wake = CreateEventW(NULL, FALSE, FALSE, NULL);
+    g_timer = util_create_precise_timer();
+    if (!g_wake || !g_timer) return;
+
+    g_repeat_running = TRUE;
+    g_repeat_thread = (HANDLE)_beginthreadex(NULL, 0, repeat_proc, NULL, 0, NULL);
+    SetThreadPriority(g_repeat_thread, THREAD_PRIORITY_HIGHEST);
+}
+
+void krepeat_cleanup(void) {
+    g_repeat_running = FALSE;
+    if (g_wake) SetEvent(g_wake); /* Unblock timer thread */
+    if (g_repeat_thread) {
+        WaitForSingleObject(g_repeat_thread, 2000);
+        CloseHandle(g_repeat_thread);
+        g_repeat_thread = NULL;
+    }
+    if (g_timer) { CloseHandle(g_timer); g_timer = NULL; }
+    if (g_wake) { CloseHandle(g_wake); g_wake = NULL; }
+}
+
+void krepeat_report(void) {
+    util_stat_report(&g_lateness, L"software repeat lateness", L"us");
+}
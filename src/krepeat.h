@@ -0,0 +1,35 @@
+/*
+ * Copyright (c) 2026 Li Ruijie
+ * Licensed under the GNU General Public License v3.0.
+ */
+
+#ifndef W10WHEEL_KREPEAT_H
+#define W10WHEEL_KREPEAT_H
+
+#include <windows.h>
+
+/*
+ * Software key repeat: OS auto-repeats are dropped in the keyboard hook and
+ * replaced by repeats injected from a high-resolution timer thread, using
+ * the per key class delay and interval from config.
+ */
+
+void krepeat_init(void);
+void krepeat_cleanup(void);
+
+/* Repeat injected by the engine (passed straight through by the hook) */
+BOOL krepeat_is_repeat(const KBDLLHOOKSTRUCT *info);
+
+/* Keyboard hook feed; TRUE if the event is an OS auto-repeat to suppress */
+BOOL krepeat_filter(const KBDLLHOOKSTRUCT *info);
+
+/* Keyboard hook removed: forget held keys and stop repeating (hook thread) */
+void krepeat_reset(void);
+
+/* Stop the current repeat, e.g. software repeat turned off (any thread) */
+void krepeat_cancel(void);
+
+/* Timer lateness in microseconds, via OutputDebugStringW */
+void krepeat_report(void);
+
+#endif
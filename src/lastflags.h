@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2026 Li Ruijie
+ * Licensed under the GNU General Public License v3.0.
+ */
+
+#ifndef W10WHEEL_LASTFLAGS_H
+#define W10WHEEL_LASTFLAGS_H
+
+#include <windows.h>
+
+/* Mouse flag bits (LastFlags.mouse) */
+#define LF_LD_RESENT      0x0001
+#define LF_RD_RESENT      0x0002
+#define LF_LD_PASSED      0x0004
+#define LF_RD_PASSED      0x0008
+#define LF_LD_SUPPRESSED  0x0010
+#define LF_RD_SUPPRESSED  0x0020
+#define LF_SD_SUPPRESSED  0x0040
+
+/*
+ * Written by the hook and waiter threads. All updates are atomic
+ * fetch-or / fetch-and, so get-and-reset is a single instruction.
+ * 36 bytes: aligned, the whole structure sits in one cache line.
+ */
+typedef struct DECLSPEC_ALIGN(64) {
+    volatile LONG mouse;              /* LF_* bits */
+    volatile LONG kd_suppressed[8];   /* 256-bit set indexed by VK code */
+} LastFlags;
+
+static inline void lf_set(volatile LONG *word, LONG bit) {
+    InterlockedOr(word, bit);
+}
+
+/* Atomically clear a bit and report whether it was set */
+static inline BOOL lf_get_reset(volatile LONG *word, LONG bit) {
+    return (InterlockedAnd(word, ~bit) & bit) != 0;
+}
+
+/* Keyboard set: 32 VK codes share each word */
+static inline void lf_set_key(LastFlags *f, int vk) {
+    vk &= 0xFF;
+    lf_set(&f->kd_suppressed[vk >> 5], (LONG)(1u << (vk & 31)));
+}
+
+static inline BOOL lf_get_reset_key(LastFlags *f, int vk) {
+    vk &= 0xFF;
+    return lf_get_reset(&f->kd_suppressed[vk >> 5], (LONG)(1u << (vk & 31)));
+}
+
+#endif
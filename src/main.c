@@ -16,6 +16,10 @@
 #include "dialog.h"
 #include "cursor.h"
 #include "rawinput.h"
+#include "keystate.h"
+#include "krepeat.h"
+#include "sysparam.h"
+#include "cfgstore.h"
 #include "ipc.h"
 #include "util.h"
 #include <wchar.h>
@@ -187,13 +191,35 @@ static void proc_exit(void) {
     ipc_server_stop();
     tray_cleanup();
     hook_unhook();
+    hook_thread_stop();
+    rawinput_cleanup();
+    cursor_cleanup();
+    krepeat_report();
+    scroll_first_wheel_report();
+    kevent_chatter_report();
+    sysparam_report();
+    krepeat_cleanup();
+    sysparam_cleanup();
     waiter_cleanup();
     scroll_cleanup();
     cfg_store_properties();
+    cfgstore_cleanup();
     util_unlock();
     util_cleanup();
 }
 
+/* Launch to message loop, via OutputDebugStringW */
+static void report_startup(LONGLONG start) {
+    LARGE_INTEGER now, freq;
+    QueryPerformanceCounter(&now);
+    QueryPerformanceFrequency(&freq);
+    wchar_t buf[64];
+    _snwprintf(buf, 64, L"tpkb: startup: %lld ms\n",
+               (long long)((now.QuadPart - start) * 1000 / freq.QuadPart));
+    buf[63] = L'\0';
+    OutputDebugStringW(buf);
+}
+
 static void proc_argv(int argc, wchar_t **argv) {
     if (argc < 2) return;
 
@@ -230,12 +256,16 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
     (void)lpCmdLine;
     (void)nCmdShow;
 
+    LARGE_INTEGER t_start;
+    QueryPerformanceCounter(&t_start);
+
     SetProcessDpiAwarenessContext(DPI_AWARENESS_CONTEXT_PER_MONITOR_AWARE_V2);
 
     /* Initialize subsystems */
     cfg_init();
     cursor_init();
     rawinput_init();
+    keystate_init();
 
     /* Process command-line args */
     int argc;
@@ -259,10 +289,13 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
     waiter_init();
     event_init();
     kevent_init();
+    krepeat_init();
+    sysparam_init();
+    cfgstore_init();
 
     /* Load full properties */
     cfg_load_properties(FALSE);
-    settings_apply_filter_keys();
+    settings_apply_filter_keys();  /* writes are queued to the sysparam worker */
 
     /* Create system tray */
     HWND hwnd = tray_init(hInstance);
@@ -271,8 +304,10 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
     /* Start IPC server */
     ipc_server_start();
 
-    /* Install mouse hook */
-    if (!hook_set_mouse()) {
+    /* Install mouse hook (on the dedicated hook thread), unless no mouse
+       trigger can fire; it is then installed on demand */
+    if (!hook_thread_start() ||
+        (cfg_is_mouse_hook_needed() && !hook_set_mouse())) {
         wchar_t err[256], msg[512];
         util_get_last_error_message(err, 256);
         _snwprintf(msg, 512, L"%s: %s",
@@ -282,10 +317,12 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
     }
     tray_start_health_timer();
 
-    /* Set keyboard hook if configured */
-    if (cfg_is_keyboard_hook())
+    /* Set keyboard hook if configured (trigger keys, repeat or debounce) */
+    if (cfg_is_keyboard_hook_needed())
         hook_set_or_unset_keyboard(TRUE);
 
+    report_startup(t_start.QuadPart);
+
     /* Main message loop */
     MSG msg;
     while (GetMessageW(&msg, NULL, 0, 0) > 0) {
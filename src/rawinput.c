@@ -4,36 +4,318 @@
  */
 
 #include "rawinput.h"
+#include "rawmotion.h"
 #include "types.h"
+#include "util.h"
+#include <process.h>
+#include <stdio.h>
+#include <stdlib.h>
 
 static SendWheelRawFn g_send_wheel_raw = NULL;
+static KeyRawFn g_key_raw = NULL;
+static DeviceResetFn g_device_reset = NULL;
 static HWND g_msg_window = NULL;
 
+/*
+ * The message window lives on its own high-priority thread, so WM_INPUT
+ * never waits behind tray, IPC, timer or settings dialog messages on the
+ * main thread.
+ */
+static HANDLE g_raw_thread = NULL;
+static unsigned g_raw_tid = 0;
+
+/*
+ * Mouse reports are processed only while a scroll session is active. In
+ * persistent mode the mouse stays registered for the process lifetime and
+ * session start/exit is just this flag: no registration round trip.
+ */
+static volatile LONG g_session = FALSE;
+static volatile LONG g_session_id = 0;  /* bumped per session start */
+static volatile LONG g_persistent = FALSE;
+
+/* WM_INPUT dispatch delay: message time to window procedure */
+static LatencyStat g_input_delay;
+
+/* Pending relative mouse reports of one device, handed over as one batch */
+static LONG g_batch_x[RAW_BATCH_MAX];
+static LONG g_batch_y[RAW_BATCH_MAX];
+static int  g_batch_count = 0;
+static int  g_batch_dev = 0;
+
+/*
+ * Mouse devices seen by the reader thread. Metadata is resolved once, on
+ * WM_INPUT_DEVICE_CHANGE arrival (or the first report of an unknown
+ * handle); the hot path is a scan of this small table. Only the reader
+ * thread touches it.
+ */
+typedef struct {
+    BOOL    used;
+    HANDLE  handle;         /* NULL for synthetic input */
+    wchar_t name[128];
+    USHORT  vid, pid;
+    BOOL    allowed;
+    DWORD   rate_start;     /* report rate: reports in the last second */
+    LONG    rate_count;
+    LONG    rate;
+    RawAbsPosition abs;     /* absolute devices: previous position */
+} RawDevice;
+
+static RawDevice g_devices[RAW_DEVICE_MAX];
+static int       g_device_next = 0;   /* replacement cursor when full */
+
+/* Allow-list of device name substrings (empty = every device) */
+static wchar_t  *g_allow = NULL;
+
+/* Screen rectangles for absolute reports, refreshed once per session */
+static LONG g_metrics_session = -1;
+static RawScreens g_screens;
+
+/*
+ * GetRawInputBuffer under WOW64 lays blocks out with the 64-bit header,
+ * so the device data of a 32-bit build starts 8 bytes past
+ * sizeof(RAWINPUTHEADER).
+ */
+static UINT g_raw_data_offset = sizeof(RAWINPUTHEADER);
+
+/* (Un)registration is posted to the window's own thread */
+#define WM_RAWINPUT_REGISTER   (WM_APP + 1)
+#define WM_RAWINPUT_UNREGISTER (WM_APP + 2)
+#define WM_RAWINPUT_REGISTER_KB   (WM_APP + 3)
+#define WM_RAWINPUT_UNREGISTER_KB (WM_APP + 4)
+#define WM_RAWINPUT_SET_ALLOW     (WM_APP + 5)
+
+#define HID_USAGE_GENERIC_MOUSE    0x02
+#define HID_USAGE_GENERIC_KEYBOARD 0x06
+
+static BOOL register_raw_device(USHORT usage, DWORD flags, HWND hwnd);
+static void flush_batch(void);
+
 void rawinput_set_send_wheel_raw(SendWheelRawFn fn) {
     g_send_wheel_raw = fn;
 }
 
+void rawinput_set_key_raw(KeyRawFn fn) {
+    g_key_raw = fn;
+}
+
+void rawinput_set_device_reset(DeviceResetFn fn) {
+    g_device_reset = fn;
+}
+
+/* ========== Device table ========== */
+
+static USHORT parse_hex_id(const wchar_t *name, const wchar_t *tag) {
+    const wchar_t *p = wcsstr(name, tag);
+    return p ? (USHORT)wcstoul(p + wcslen(tag), NULL, 16) : 0;
+}
+
+static BOOL is_allowed(const wchar_t *name) {
+    if (!g_allow || !g_allow[0]) return TRUE;
+
+    wchar_t upper[128];
+    wcsncpy(upper, name, 127);
+    upper[127] = L'\0';
+    _wcsupr(upper);
+
+    for (const wchar_t *p = g_allow; *p; ) {
+        const wchar_t *end = wcschr(p, L',');
+        size_t len = end ? (size_t)(end - p) : wcslen(p);
+        wchar_t tok[128];
+        if (len > 0 && len < 128) {
+            wcsncpy(tok, p, len);
+            tok[len] = L'\0';
+            _wcsupr(tok);
+            if (wcsstr(upper, tok)) return TRUE;
+        }
+        if (!end) break;
+        p = end + 1;
+    }
+    return FALSE;
+}
+
+static void device_report(const wchar_t *event, const RawDevice *d) {
+    wchar_t buf[256];
+    _snwprintf(buf, 256, L"tpkb: raw device %s: %s VID=%04X PID=%04X %s rate=%ld/s\n",
+               event, d->name[0] ? d->name : L"(synthetic)", d->vid, d->pid,
+               d->allowed ? L"allowed" : L"ignored", (long)d->rate);
+    buf[255] = L'\0';
+    OutputDebugStringW(buf);
+}
+
+static int device_add(HANDLE h) {
+    int slot = -1;
+    for (int i = 0; i < RAW_DEVICE_MAX; i++) {
+        if (g_devices[i].used && g_devices[i].handle == h) return i;
+        if (slot < 0 && !g_devices[i].used) slot = i;
+    }
+    if (slot < 0) {
+        slot = g_device_next;
+        g_device_next = (g_device_next + 1) % RAW_DEVICE_MAX;
+    }
+
+    /* Reports batched for the slot's previous device go out under it */
+    if (g_batch_dev == slot) flush_batch();
+    if (g_device_reset) g_device_reset(slot);
+
+    RawDevice *d = &g_devices[slot];
+    ZeroMemory(d, sizeof(*d));
+    d->used = TRUE;
+    d->handle = h;
+    UINT len = 128;
+    if (h && GetRawInputDeviceInfoW(h, RIDI_DEVICENAME, d->name, &len) == (UINT)-1)
+        d->name[0] = L'\0';
+    d->vid = parse_hex_id(d->name, L"VID_");
+    d->pid = parse_hex_id(d->name, L"PID_");
+    d->allowed = is_allowed(d->name);
+    d->rate_start = GetTickCount();
+    d->abs.session = -1;
+    device_report(L"arrival", d);
+    return slot;
+}
+
+static void device_remove(HANDLE h) {
+    for (int i = 0; i < RAW_DEVICE_MAX; i++) {
+        if (g_devices[i].used && g_devices[i].handle == h) {
+            device_report(L"removal", &g_devices[i]);
+            g_devices[i].used = FALSE;
+            return;
+        }
+    }
+}
+
+/* Hot path: synthetic input (NULL handle) gets a slot of its own too */
+static int device_slot(HANDLE h) {
+    for (int i = 0; i < RAW_DEVICE_MAX; i++)
+        if (g_devices[i].used && g_devices[i].handle == h)
+            return i;
+    return device_add(h);
+}
+
+static void set_allow(wchar_t *list) {
+    free(g_allow);
+    g_allow = list;
+    for (int i = 0; i < RAW_DEVICE_MAX; i++)
+        if (g_devices[i].used)
+            g_devices[i].allowed = is_allowed(g_devices[i].name);
+}
+
+/* ========== Absolute devices ========== */
+
+static void refresh_metrics(void) {
+    RECT *v = &g_screens.virtual_desktop;
+    v->left = GetSystemMetrics(SM_XVIRTUALSCREEN);
+    v->top = GetSystemMetrics(SM_YVIRTUALSCREEN);
+    v->right = v->left + GetSystemMetrics(SM_CXVIRTUALSCREEN);
+    v->bottom = v->top + GetSystemMetrics(SM_CYVIRTUALSCREEN);
+    SetRect(&g_screens.primary, 0, 0, GetSystemMetrics(SM_CXSCREEN), GetSystemMetrics(SM_CYSCREEN));
+    g_metrics_session = g_session_id;
+}
+
+/* ========== Report handling ========== */
+
+static void flush_batch(void) {
+    if (g_batch_count && g_send_wheel_raw)
+        g_send_wheel_raw(g_batch_dev, g_batch_x, g_batch_y, g_batch_count);
+    g_batch_count = 0;
+}
+
+static void add_report(const RAWINPUTHEADER *h, const void *data) {
+    if (h->dwType == RIM_TYPEMOUSE) {
+        const RAWMOUSE *m = (const RAWMOUSE *)data;
+        if (!g_session) return;
+        /* Attribute change notice: lLastX/Y carry no motion */
+        if (m->usFlags & MOUSE_ATTRIBUTES_CHANGED) return;
+
+        int dev = device_slot(h->hDevice);
+        RawDevice *d = &g_devices[dev];
+        d->rate_count++;
+        DWORD now = GetTickCount();
+        if (now - d->rate_start >= 1000) {
+            d->rate = (LONG)(d->rate_count * 1000 / (LONG)(now - d->rate_start));
+            d->rate_count = 0;
+            d->rate_start = now;
+        }
+        if (!d->allowed) return;
+
+        if ((m->usFlags & MOUSE_MOVE_ABSOLUTE) && g_metrics_session != g_session_id)
+            refresh_metrics();
+        LONG dx, dy;
+        if (!raw_motion_delta(&d->abs, g_session_id, m->usFlags, m->lLastX, m->lLastY,
+                              &g_screens, &dx, &dy))
+            return;
+
+        /* One device per batch */
+        if (dev != g_batch_dev) {
+            flush_batch();
+            g_batch_dev = dev;
+        }
+        g_batch_x[g_batch_count] = dx;
+        g_batch_y[g_batch_count] = dy;
+        if (++g_batch_count == RAW_BATCH_MAX) flush_batch();
+    } else if (h->dwType == RIM_TYPEKEYBOARD) {
+        const RAWKEYBOARD *k = (const RAWKEYBOARD *)data;
+        if (g_key_raw)
+            g_key_raw(k->VKey, k->MakeCode, k->Flags);
+    }
+}
+
+/*
+ * The report that raised WM_INPUT is read first (it is not in the
+ * buffer), then everything queued behind it is drained in bulk, so a
+ * high-rate device costs one message and a few syscalls per wake.
+ */
 static void proc_raw_input(LPARAM lParam) {
     RAWINPUT ri;
     UINT size = sizeof(ri);
-    if (GetRawInputData((HRAWINPUT)lParam, RID_INPUT, &ri, &size, sizeof(RAWINPUTHEADER)) == (UINT)-1)
-        return;
+    if (GetRawInputData((HRAWINPUT)lParam, RID_INPUT, &ri, &size, sizeof(RAWINPUTHEADER)) != (UINT)-1)
+        add_report(&ri.header, &ri.data);
 
-    if (ri.header.dwType == RIM_TYPEMOUSE && ri.data.mouse.usFlags == MOUSE_MOVE_RELATIVE) {
-        if (g_send_wheel_raw)
-            g_send_wheel_raw(ri.data.mouse.lLastX, ri.data.mouse.lLastY);
+    static UINT64 buf[1024]; /* 8 KB, QWORD aligned as the API requires */
+    for (;;) {
+        size = sizeof(buf);
+        UINT n = GetRawInputBuffer((PRAWINPUT)buf, &size, sizeof(RAWINPUTHEADER));
+        if (n == 0 || n == (UINT)-1) break;
+        PRAWINPUT block = (PRAWINPUT)buf;
+        for (UINT i = 0; i < n; i++) {
+            add_report(&block->header, (const BYTE *)block + g_raw_data_offset);
+            block = NEXTRAWINPUTBLOCK(block);
+        }
     }
+    flush_batch();
 }
 
 static LRESULT CALLBACK msg_wnd_proc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
-    if (msg == WM_INPUT) {
+    switch (msg) {
+    case WM_INPUT:
+        util_stat_add(&g_input_delay, (LONG)(GetTickCount() - (DWORD)GetMessageTime()));
         proc_raw_input(lParam);
         return 0;
+    case WM_INPUT_DEVICE_CHANGE:
+        if (wParam == GIDC_ARRIVAL) device_add((HANDLE)lParam);
+        else if (wParam == GIDC_REMOVAL) device_remove((HANDLE)lParam);
+        return 0;
+    case WM_RAWINPUT_SET_ALLOW:
+        set_allow((wchar_t *)lParam);
+        return 0;
+    case WM_RAWINPUT_REGISTER:
+        register_raw_device(HID_USAGE_GENERIC_MOUSE, RIDEV_INPUTSINK | RIDEV_DEVNOTIFY, hwnd);
+        return 0;
+    case WM_RAWINPUT_UNREGISTER:
+        register_raw_device(HID_USAGE_GENERIC_MOUSE, RIDEV_REMOVE, NULL);
+        return 0;
+    case WM_RAWINPUT_REGISTER_KB:
+        register_raw_device(HID_USAGE_GENERIC_KEYBOARD, RIDEV_INPUTSINK, hwnd);
+        return 0;
+    case WM_RAWINPUT_UNREGISTER_KB:
+        register_raw_device(HID_USAGE_GENERIC_KEYBOARD, RIDEV_REMOVE, NULL);
+        return 0;
     }
     return DefWindowProcW(hwnd, msg, wParam, lParam);
 }
 
-void rawinput_init(void) {
+static unsigned __stdcall raw_thread_proc(void *arg) {
+    HANDLE ready = (HANDLE)arg;
+
     WNDCLASSEXW wc = { sizeof(wc) };
     wc.lpfnWndProc = msg_wnd_proc;
     wc.hInstance = GetModuleHandleW(NULL);
@@ -43,21 +325,97 @@ void rawinput_init(void) {
     g_msg_window = CreateWindowExW(0, L"tpkbRawInput", L"", 0,
                                    0, 0, 0, 0, HWND_MESSAGE, NULL,
                                    wc.hInstance, NULL);
+    SetEvent(ready);
+    if (!g_msg_window) return 1;
+
+    MSG msg;
+    while (GetMessageW(&msg, NULL, 0, 0) > 0)
+        DispatchMessageW(&msg);
+
+    DestroyWindow(g_msg_window);
+    g_msg_window = NULL;
+    return 0;
 }
 
-static BOOL register_raw_device(DWORD flags, HWND hwnd) {
+void rawinput_init(void) {
+#ifndef _WIN64
+    BOOL wow64 = FALSE;
+    if (IsWow64Process(GetCurrentProcess(), &wow64) && wow64)
+        g_raw_data_offset = sizeof(RAWINPUTHEADER) + 8;
+#endif
+
+    HANDLE ready = CreateEventW(NULL, TRUE, FALSE, NULL);
+    if (!ready) return;
+    g_raw_thread = (HANDLE)_beginthreadex(NULL, 0, raw_thread_proc, ready, 0, &g_raw_tid);
+    if (g_raw_thread) {
+        SetThreadPriority(g_raw_thread, THREAD_PRIORITY_HIGHEST);
+        WaitForSingleObject(ready, INFINITE);
+    }
+    CloseHandle(ready);
+}
+
+void rawinput_cleanup(void) {
+    if (!g_raw_thread) return;
+    PostThreadMessageW(g_raw_tid, WM_QUIT, 0, 0);
+    WaitForSingleObject(g_raw_thread, 2000);
+    CloseHandle(g_raw_thread);
+    g_raw_thread = NULL;
+    g_raw_tid = 0;
+}
+
+static BOOL register_raw_device(USHORT usage, DWORD flags, HWND hwnd) {
     RAWINPUTDEVICE rid;
     rid.usUsagePage = 0x01; /* HID_USAGE_PAGE_GENERIC */
-    rid.usUsage = 0x02;     /* HID_USAGE_GENERIC_MOUSE */
+    rid.usUsage = usage;
     rid.dwFlags = flags;
     rid.hwndTarget = hwnd;
     return RegisterRawInputDevices(&rid, 1, sizeof(rid));
 }
 
+/* Safe to call from the hook thread: never blocks on the window's thread */
 void rawinput_register(void) {
-    register_raw_device(RIDEV_INPUTSINK, g_msg_window);
+    InterlockedIncrement(&g_session_id);
+    InterlockedExchange(&g_session, TRUE);
+    if (!g_persistent)
+        PostMessageW(g_msg_window, WM_RAWINPUT_REGISTER, 0, 0);
 }
 
 void rawinput_unregister(void) {
-    register_raw_device(RIDEV_REMOVE, NULL);
+    InterlockedExchange(&g_session, FALSE);
+    if (!g_persistent)
+        PostMessageW(g_msg_window, WM_RAWINPUT_UNREGISTER, 0, 0);
+}
+
+void rawinput_set_persistent(BOOL on) {
+    if (InterlockedExchange(&g_persistent, on) == on) return;
+    if (on)
+        PostMessageW(g_msg_window, WM_RAWINPUT_REGISTER, 0, 0);
+    else if (!g_session)
+        PostMessageW(g_msg_window, WM_RAWINPUT_UNREGISTER, 0, 0);
+}
+
+/* The reader thread takes ownership of the copy */
+void rawinput_set_device_allow(const wchar_t *list) {
+    wchar_t *copy = _wcsdup(list ? list : L"");
+    if (!copy) return;
+    if (!g_msg_window || !PostMessageW(g_msg_window, WM_RAWINPUT_SET_ALLOW, 0, (LPARAM)copy))
+        free(copy);
+}
+
+void rawinput_register_keyboard(void) {
+    PostMessageW(g_msg_window, WM_RAWINPUT_REGISTER_KB, 0, 0);
+}
+
+void rawinput_unregister_keyboard(void) {
+    PostMessageW(g_msg_window, WM_RAWINPUT_UNREGISTER_KB, 0, 0);
+}
+
+/* ========== WM_INPUT delay instrumentation ========== */
+
+void rawinput_delay_reset(void) {
+    util_stat_reset(&g_input_delay);
+}
+
+void rawinput_delay_report(const wchar_t *label) {
+    util_stat_report(&g_input_delay, label, L"ms");
 }
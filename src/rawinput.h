@@ -8,11 +8,34 @@
 
 #include <windows.h>
 
-typedef void (*SendWheelRawFn)(int x, int y);
+/* Relative mouse reports, batched per wake and device (structure of arrays) */
+#define RAW_BATCH_MAX  64
+#define RAW_DEVICE_MAX 16   /* dev: slot in the reader's device table */
+typedef void (*SendWheelRawFn)(int dev, const LONG *xs, const LONG *ys, int count);
+typedef void (*KeyRawFn)(USHORT vkey, USHORT make, USHORT flags);
+typedef void (*DeviceResetFn)(int dev);
 
-void rawinput_init(void);
+void rawinput_init(void);     /* starts the reader thread */
+void rawinput_cleanup(void);
 void rawinput_set_send_wheel_raw(SendWheelRawFn fn);
-void rawinput_register(void);
-void rawinput_unregister(void);
+/* Slot dev now belongs to a new device: drop per-slot state kept for it */
+void rawinput_set_device_reset(DeviceResetFn fn);
+void rawinput_register(void);    /* scroll session start */
+void rawinput_unregister(void);  /* scroll session exit */
+
+/* Keep the mouse registered for the process lifetime */
+void rawinput_set_persistent(BOOL on);
+
+/* Comma-separated device name substrings, e.g. "VID_17EF&PID_6009" */
+void rawinput_set_device_allow(const wchar_t *list);
+
+/* Keyboard raw input (modifier tracking while the keyboard hook is off) */
+void rawinput_set_key_raw(KeyRawFn fn);
+void rawinput_register_keyboard(void);
+void rawinput_unregister_keyboard(void);
+
+/* WM_INPUT dispatch delay, via OutputDebugStringW */
+void rawinput_delay_reset(void);
+void rawinput_delay_report(const wchar_t *label);
 
 #endif
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2026 Li Ruijie
+ * Licensed under the GNU General Public License v3.0.
+ */
+
+#ifndef W10WHEEL_RAWMOTION_H
+#define W10WHEEL_RAWMOTION_H
+
+#include <windows.h>
+
+#ifndef MOUSE_ATTRIBUTES_CHANGED
+#define MOUSE_ATTRIBUTES_CHANGED 0x04
+#endif
+
+/*
+ * Raw mouse report to scroll delta, per device. Relative reports carry
+ * the delta. Pens, RDP and VM pointers report 0..65535 over the primary
+ * monitor or, with MOUSE_VIRTUAL_DESKTOP, the whole virtual desktop:
+ * those are mapped to desktop pixels and differenced against the
+ * device's previous absolute position. Pure; the caller owns the state.
+ */
+
+typedef struct {
+    RECT primary;
+    RECT virtual_desktop;
+} RawScreens;
+
+/* Previous absolute position, valid while session matches the current one */
+typedef struct {
+    LONG session;           /* -1 = none */
+    LONG x, y;
+} RawAbsPosition;
+
+/*
+ * FALSE when the report has no motion to send: an attribute change
+ * notice (lLastX/Y carry none), or an absolute report without a valid
+ * origin (first of the session, or after relative motion, which the
+ * origin no longer includes); that one only sets the origin.
+ */
+static inline BOOL raw_motion_delta(RawAbsPosition *pos, LONG session, USHORT flags,
+                                    LONG last_x, LONG last_y, const RawScreens *screens,
+                                    LONG *dx, LONG *dy) {
+    if (flags & MOUSE_ATTRIBUTES_CHANGED) return FALSE;
+
+    if (!(flags & MOUSE_MOVE_ABSOLUTE)) {
+        pos->session = -1;
+        *dx = last_x;
+        *dy = last_y;
+        return TRUE;
+    }
+
+    const RECT *r = (flags & MOUSE_VIRTUAL_DESKTOP) ? &screens->virtual_desktop : &screens->primary;
+    LONG x = r->left + (LONG)((LONGLONG)last_x * (r->right - r->left) / 65535);
+    LONG y = r->top + (LONG)((LONGLONG)last_y * (r->bottom - r->top) / 65535);
+    BOOL valid = pos->session == session;
+    *dx = x - pos->x;
+    *dy = y - pos->y;
+    pos->x = x;
+    pos->y = y;
+    pos->session = session;
+    return valid;
+}
+
+#endif
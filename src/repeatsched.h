@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2026 Li Ruijie
+ * Licensed under the GNU General Public License v3.0.
+ */
+
+#ifndef W10WHEEL_REPEATSCHED_H
+#define W10WHEEL_REPEATSCHED_H
+
+#include <windows.h>
+
+/*
+ * Software repeat deadlines, in any monotonic clock unit (QPC ticks in
+ * krepeat.c, a virtual clock in the tests). Deadlines are absolute and
+ * advance by whole intervals, so lateness never accumulates into drift.
+ * A deadline already past once the next is due means a stall: the
+ * schedule restarts from now instead of bursting the missed repeats.
+ */
+
+typedef struct {
+    LONGLONG next;          /* deadline of the next repeat */
+    LONGLONG interval;
+} RepeatSchedule;
+
+/* Key armed at time armed: first repeat after delay, then every interval */
+static inline void repeat_sched_start(RepeatSchedule *s, LONGLONG armed,
+                                      LONGLONG delay, LONGLONG interval) {
+    s->interval = interval < 1 ? 1 : interval;
+    s->next = armed + delay;
+}
+
+/* A repeat went out at now (at or after s->next) */
+static inline void repeat_sched_fired(RepeatSchedule *s, LONGLONG now) {
+    s->next += s->interval;
+    if (s->next <= now)
+        s->next = now + s->interval;
+}
+
+#endif
@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2026 Li Ruijie
+ * Licensed under the GNU General Public License v3.0.
+ */
+
+#ifndef W10WHEEL_RUNSTATE_H
+#define W10WHEEL_RUNSTATE_H
+
+#include <windows.h>
+
+/* Runtime state word (RS_* bits, one atomic LONG) */
+#define RS_PASS_MODE        0x0001
+#define RS_SCROLL_MODE      0x0002
+#define RS_SCROLL_STARTING  0x0004
+#define RS_SCROLL_RELEASED  0x0008
+#define RS_DRAG_PRE_SCROLL  0x0010
+#define RS_DRAGGED          0x0020
+#define RS_EXIT_PENDING     0x0040
+
+/*
+ * Scroll session transitions. Each is a pure function of the old word,
+ * applied with one CAS, so the hook and waiter threads racing a start
+ * against the second trigger up agree on which of them exits.
+ */
+
+/* Start committed; RS_EXIT_PENDING survives for the starter to act on */
+static inline LONG rs_start(LONG st) {
+    return (st & ~RS_SCROLL_STARTING) | RS_SCROLL_MODE;
+}
+
+static inline LONG rs_exit(LONG st) {
+    return st & ~(RS_SCROLL_MODE | RS_SCROLL_RELEASED | RS_EXIT_PENDING);
+}
+
+/* Second trigger down offered: starting, unless the start already committed */
+static inline LONG rs_starting(LONG st) {
+    return (st & RS_SCROLL_MODE) ? (st & ~RS_SCROLL_STARTING)
+                                 : ((st | RS_SCROLL_STARTING) & ~RS_EXIT_PENDING);
+}
+
+/* Second trigger up ahead of the start: leave the exit to the starter */
+static inline LONG rs_defer_exit(LONG st) {
+    return st | RS_EXIT_PENDING;
+}
+
+#endif
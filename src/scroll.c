@@ -7,6 +7,9 @@
 #include "config.h"
 #include "cursor.h"
 #include "rawinput.h"
+#include "keystate.h"
+#include "batch.h"
+#include "util.h"
 #include <math.h>
 #include <process.h>
 
@@ -14,6 +17,7 @@
 
 typedef struct {
     INPUT msg;
+    LONGLONG due;   /* QPC time to send at, stamped at enqueue; 0 = now */
 } InputItem;
 
 #define INPUT_QUEUE_SIZE 256
@@ -26,17 +30,30 @@ static HANDLE g_iq_space_sem = NULL; /* counts available space */
 static HANDLE g_sender_thread = NULL;
 static volatile BOOL g_sender_running = FALSE;
 static CRITICAL_SECTION g_iq_cs;
-
-static void enqueue_input(const INPUT *inp) {
+static HANDLE g_send_timer = NULL;   /* precise wait for deferred items */
+static LONGLONG g_qpf = 1;
+
+static void enqueue_input_delayed(const INPUT *inp, DWORD delay) {
+    LONGLONG due = 0;
+    if (delay) {
+        LARGE_INTEGER now;
+        QueryPerformanceCounter(&now);
+        due = now.QuadPart + (LONGLONG)delay * g_qpf / 1000;
+    }
     if (WaitForSingleObject(g_iq_space_sem, 0) != WAIT_OBJECT_0)
         return;
     EnterCriticalSection(&g_iq_cs);
     g_input_queue[g_iq_head].msg = *inp;
+    g_input_queue[g_iq_head].due = due;
     g_iq_head = (g_iq_head + 1) % INPUT_QUEUE_SIZE;
     ReleaseSemaphore(g_iq_sem, 1, NULL);
     LeaveCriticalSection(&g_iq_cs);
 }
 
+static void enqueue_input(const INPUT *inp) {
+    enqueue_input_delayed(inp, 0);
+}
+
 static BOOL enqueue_inputs(const INPUT *msgs, int count) {
     for (int i = 0; i < count; i++) {
         if (WaitForSingleObject(g_iq_space_sem, 0) != WAIT_OBJECT_0) {
@@ -48,6 +65,7 @@ static BOOL enqueue_inputs(const INPUT *msgs, int count) {
     LONG head = g_iq_head;
     for (int i = 0; i < count; i++) {
         g_input_queue[head].msg = msgs[i];
+        g_input_queue[head].due = 0;
         head = (head + 1) % INPUT_QUEUE_SIZE;
     }
     g_iq_head = head;
@@ -56,6 +74,33 @@ static BOOL enqueue_inputs(const INPUT *msgs, int count) {
     return TRUE;
 }
 
+/*
+ * Waits until the QPC time due. Sleep() rounds up to the scheduler tick
+ * (~15.6 ms by default); the high-resolution timer keeps a 1 ms deferral
+ * close to 1 ms.
+ */
+static void wait_until(LONGLONG due) {
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    LONGLONG remain = due - now.QuadPart;
+    if (remain <= 0) return;
+    if (!g_send_timer) {
+        Sleep((DWORD)((remain * 1000 + g_qpf - 1) / g_qpf));
+        return;
+    }
+    /* Relative due time in 100 ns units */
+    LARGE_INTEGER rel;
+    rel.QuadPart = -(remain * 10000000 / g_qpf);
+    if (rel.QuadPart == 0) rel.QuadPart = -1;
+    if (SetWaitableTimer(g_send_timer, &rel, 0, NULL, NULL, FALSE))
+        WaitForSingleObject(g_send_timer, INFINITE);
+}
+
+/*
+ * Items are sent in queue order. A deferred item first flushes everything
+ * queued before it, then waits here until its due time, so deferred
+ * resends keep their order without the hook callback ever sleeping.
+ */
 static unsigned __stdcall sender_proc(void *arg) {
     (void)arg;
     INPUT batch[INPUT_QUEUE_SIZE];
@@ -63,16 +108,21 @@ static unsigned __stdcall sender_proc(void *arg) {
         WaitForSingleObject(g_iq_sem, INFINITE);
         if (!g_sender_running) break;
         LONG tail = g_iq_tail;
-        int count = 0;
-        batch[count++] = g_input_queue[tail].msg;
-        tail = (tail + 1) % INPUT_QUEUE_SIZE;
-        while (count < INPUT_QUEUE_SIZE &&
-               WaitForSingleObject(g_iq_sem, 0) == WAIT_OBJECT_0) {
-            batch[count++] = g_input_queue[tail].msg;
+        int count = 0, taken = 0;
+        do {
+            const InputItem *item = &g_input_queue[tail];
+            if (item->due) {
+                if (count) SendInput((UINT)count, batch, sizeof(INPUT));
+                count = 0;
+                wait_until(item->due);
+            }
+            batch[count++] = item->msg;
+            taken++;
             tail = (tail + 1) % INPUT_QUEUE_SIZE;
-        }
+        } while (taken < INPUT_QUEUE_SIZE &&
+                 WaitForSingleObject(g_iq_sem, 0) == WAIT_OBJECT_0);
         InterlockedExchange(&g_iq_tail, tail);
-        ReleaseSemaphore(g_iq_space_sem, count, NULL);
+        ReleaseSemaphore(g_iq_space_sem, taken, NULL);
         SendInput((UINT)count, batch, sizeof(INPUT));
     }
     return 0;
@@ -111,8 +161,32 @@ static INPUT create_input(POINT pt, int data, int flags, DWORD time, DWORD extra
     return inp;
 }
 
+/*
+ * Time from trigger confirmation (scroll_init_scroll) to the first wheel
+ * event of the session, split by whether the plan was prepared ahead.
+ */
+#define FIRST_WHEEL_WARM 1
+#define FIRST_WHEEL_COLD 2
+
+static LatencyStat g_first_wheel[2];
+static volatile LONG g_first_wheel_pending = 0;
+static LONGLONG g_confirm_time;
+
+static void record_first_wheel(void) {
+    LONG kind = InterlockedExchange(&g_first_wheel_pending, 0);
+    if (!kind) return;
+    LARGE_INTEGER now, freq;
+    QueryPerformanceCounter(&now);
+    QueryPerformanceFrequency(&freq);
+    LONG us = (LONG)((now.QuadPart - g_confirm_time) * 1000000 / freq.QuadPart);
+    util_stat_add(&g_first_wheel[kind - 1], us);
+}
+
 void scroll_send_input(POINT pt, int data, int flags, DWORD time, DWORD extra) {
     INPUT inp = create_input(pt, data, flags, time, extra);
+    if (g_first_wheel_pending &&
+        (flags & (TPKB_MOUSEEVENTF_WHEEL | TPKB_MOUSEEVENTF_HWHEEL)))
+        record_first_wheel();
     enqueue_input(&inp);
 }
 
@@ -159,64 +233,131 @@ void scroll_resend_up(const MouseEvent *me) {
     scroll_send_input(me->info.pt, 0, flag, 0, g_resend_tag);
 }
 
+/* Deferred resend: the sender thread waits, not the hook callback */
+void scroll_resend_up_delayed(const MouseEvent *me, DWORD delay) {
+    int flag;
+    switch (me->type) {
+    case ME_LEFT_UP:  flag = TPKB_MOUSEEVENTF_LEFTUP;  break;
+    case ME_RIGHT_UP: flag = TPKB_MOUSEEVENTF_RIGHTUP; break;
+    default: return;
+    }
+    INPUT inp = create_input(me->info.pt, 0, flag, 0, g_resend_tag);
+    enqueue_input_delayed(&inp, delay);
+}
+
 /* ========== Modifier key detection ========== */
 
-static BOOL check_async_key(int vk) {
-    return (GetAsyncKeyState(vk) & 0xF000) != 0;
-}
+/* Single load of the tracked key state (keystate.c), no syscall */
+BOOL scroll_check_shift(void) { return (keystate_get() & KS_SHIFT) != 0; }
+BOOL scroll_check_ctrl(void)  { return (keystate_get() & KS_CTRL) != 0; }
+BOOL scroll_check_alt(void)   { return (keystate_get() & KS_ALT) != 0; }
+BOOL scroll_check_esc(void)   { return (keystate_get() & KS_ESC) != 0; }
 
-BOOL scroll_check_shift(void) { return check_async_key(VK_SHIFT); }
-BOOL scroll_check_ctrl(void)  { return check_async_key(VK_CONTROL); }
-BOOL scroll_check_alt(void)   { return check_async_key(VK_MENU); }
-BOOL scroll_check_esc(void)   { return check_async_key(VK_ESCAPE); }
+/* ========== Scroll plan ========== */
 
-/* ========== Scroll engine state ========== */
+/*
+ * Everything a session reads from config, built once per settings
+ * generation and per-key options and never modified after publication.
+ * Sessions pin the current plan; senders read it through one pointer, so
+ * a settings change can never be observed halfway through a session.
+ *
+ * Plans are reference counted: g_plan, the session and each raw batch in
+ * flight hold one. References are only taken under g_scroll_state_cs
+ * from a pointer that already holds one, so a count never rises from 0.
+ */
+#define PLAN_ACCEL_MAX  64
+
+typedef struct ScrollPlan ScrollPlan;
+
+struct ScrollPlan {
+    LONG generation;
+    int  key_opts;
+
+    int  (*add_accel_fn)(const ScrollPlan *, int);
+    int  (*reverse_v_fn)(int);
+    int  (*reverse_h_fn)(int);
+    int  (*reverse_delta_fn)(int);
+    void (*send_v_wheel)(const ScrollPlan *, POINT, int);
+    void (*send_h_wheel)(const ScrollPlan *, POINT, int);
+    void (*send_wheel_fn)(const ScrollPlan *, POINT, int, int, int, int);
+    BOOL swap;
+
+    /* Acceleration (copied: the custom table can change under a session) */
+    int    accel_count;
+    int    accel_threshold[PLAN_ACCEL_MAX];
+    double accel_multiplier[PLAN_ACCEL_MAX];
+
+    /* Real wheel mode */
+    int  v_wheel_move, h_wheel_move;
+    BOOL quick_turn, quick_first;
+    int  wheel_delta;
+
+    /* VH adjuster */
+    VHDirection (*switch_vhd_fn)(const ScrollPlan *, int, int);
+    int  switching_threshold;
+    int  first_min_threshold;
+    BOOL first_prefer_vertical;
+    BOOL cursor_change;
+
+    /* Standard mode */
+    int  vert_thr, horiz_thr;
+    BOOL horiz_enabled;
+
+    /* Direct standard mode: whole batches go through the batch kernel */
+    BOOL use_batch;
+    BatchParams batch;
+
+    volatile LONG refs;
+};
+
+static ScrollPlan *volatile g_plan = NULL;          /* latest built */
+static ScrollPlan *volatile g_session_plan = NULL;  /* pinned by the session */
+
+/* Caller holds g_scroll_state_cs and a pointer that owns a reference */
+static ScrollPlan *plan_ref(ScrollPlan *p) {
+    if (p) InterlockedIncrement(&p->refs);
+    return p;
+}
 
-static int (*add_accel_fn)(int) = NULL;
-static int (*reverse_v_fn)(int) = NULL;
-static int (*reverse_h_fn)(int) = NULL;
-static int (*reverse_delta_fn)(int) = NULL;
+static void plan_release(ScrollPlan *p) {
+    if (p && InterlockedDecrement(&p->refs) == 0) free(p);
+}
 
 static int pass_int(int d) { return d; }
 static int flip_int(int d) { return -d; }
 
-static BOOL swap_enabled = FALSE;
-
-/* Acceleration lookup */
-static const int *accel_threshold = NULL;
-static const double *accel_multiplier = NULL;
-static int accel_count = 0;
+static int pass_accel(const ScrollPlan *p, int d) { (void)p; return d; }
 
-static int get_nearest_index(int d) {
+static int get_nearest_index(const ScrollPlan *p, int d) {
     int ad = abs(d);
-    for (int i = 0; i < accel_count; i++) {
-        if (accel_threshold[i] == ad) return i;
-        if (accel_threshold[i] > ad) {
+    for (int i = 0; i < p->accel_count; i++) {
+        if (p->accel_threshold[i] == ad) return i;
+        if (p->accel_threshold[i] > ad) {
             if (i == 0) return 0;
-            return (accel_threshold[i] - ad < abs(accel_threshold[i - 1] - ad)) ? i : i - 1;
+            return (p->accel_threshold[i] - ad < abs(p->accel_threshold[i - 1] - ad)) ? i : i - 1;
         }
     }
-    return accel_count - 1;
+    return p->accel_count - 1;
 }
 
-static int add_accel(int d) {
-    int i = get_nearest_index(d);
-    return (int)((double)d * accel_multiplier[i]);
+static int add_accel(const ScrollPlan *p, int d) {
+    int i = get_nearest_index(p, d);
+    return (int)((double)d * p->accel_multiplier[i]);
 }
 
+/* ========== Scroll engine state ========== */
+
 /* Scroll state lock (protects scroll_start, raw_total, prev_d across threads) */
 static CRITICAL_SECTION g_scroll_state_cs;
 
-/* Real wheel state */
+/* Per-session counters (the only state a session start resets) */
 static int vw_count, hw_count;
 static MoveDirection v_last_move, h_last_move;
-static int v_wheel_move, h_wheel_move;
-static BOOL quick_turn;
-static int wheel_delta;
 static int scroll_start_x, scroll_start_y;
+static VHDirection fixed_vhd, latest_vhd;
 
-/* Raw input accumulators */
-static int raw_total_x, raw_total_y;
+/* Raw input accumulators, per device slot */
+static int raw_total_x[RAW_DEVICE_MAX], raw_total_y[RAW_DEVICE_MAX];
 
 static BOOL is_turn_move(MoveDirection last, int d) {
     if (last == DIR_ZERO) return FALSE;
@@ -224,186 +365,285 @@ static BOOL is_turn_move(MoveDirection last, int d) {
     return d > 0;
 }
 
-static int get_v_wheel_delta(int input) {
-    int delta = wheel_delta;
+static int get_v_wheel_delta(const ScrollPlan *p, int input) {
+    int delta = p->wheel_delta;
     int res = input > 0 ? -delta : delta;
-    return reverse_delta_fn(res);
+    return p->reverse_delta_fn(res);
 }
 
-static int get_h_wheel_delta(int input) {
-    return -get_v_wheel_delta(input);
+static int get_h_wheel_delta(const ScrollPlan *p, int input) {
+    return -get_v_wheel_delta(p, input);
 }
 
 /* Send wheel functions */
-static void send_real_v_wheel(POINT pt, int d) {
+static void send_real_v_wheel(const ScrollPlan *p, POINT pt, int d) {
     vw_count += abs(d);
-    if (quick_turn && is_turn_move(v_last_move, d)) {
+    if (p->quick_turn && is_turn_move(v_last_move, d)) {
         vw_count = abs(d);
-        scroll_send_input(pt, get_v_wheel_delta(d), TPKB_MOUSEEVENTF_WHEEL, 0, 0);
-    } else while (vw_count >= v_wheel_move) {
-        scroll_send_input(pt, get_v_wheel_delta(d), TPKB_MOUSEEVENTF_WHEEL, 0, 0);
-        vw_count -= v_wheel_move;
+        scroll_send_input(pt, get_v_wheel_delta(p, d), TPKB_MOUSEEVENTF_WHEEL, 0, 0);
+    } else while (vw_count >= p->v_wheel_move) {
+        scroll_send_input(pt, get_v_wheel_delta(p, d), TPKB_MOUSEEVENTF_WHEEL, 0, 0);
+        vw_count -= p->v_wheel_move;
     }
     v_last_move = d > 0 ? DIR_PLUS : DIR_MINUS;
 }
 
-static void send_real_h_wheel(POINT pt, int d) {
+static void send_real_h_wheel(const ScrollPlan *p, POINT pt, int d) {
     hw_count += abs(d);
-    if (quick_turn && is_turn_move(h_last_move, d)) {
+    if (p->quick_turn && is_turn_move(h_last_move, d)) {
         hw_count = abs(d);
-        scroll_send_input(pt, get_h_wheel_delta(d), TPKB_MOUSEEVENTF_HWHEEL, 0, 0);
-    } else while (hw_count >= h_wheel_move) {
-        scroll_send_input(pt, get_h_wheel_delta(d), TPKB_MOUSEEVENTF_HWHEEL, 0, 0);
-        hw_count -= h_wheel_move;
+        scroll_send_input(pt, get_h_wheel_delta(p, d), TPKB_MOUSEEVENTF_HWHEEL, 0, 0);
+    } else while (hw_count >= p->h_wheel_move) {
+        scroll_send_input(pt, get_h_wheel_delta(p, d), TPKB_MOUSEEVENTF_HWHEEL, 0, 0);
+        hw_count -= p->h_wheel_move;
     }
     h_last_move = d > 0 ? DIR_PLUS : DIR_MINUS;
 }
 
-static void send_direct_v_wheel(POINT pt, int d) {
-    scroll_send_input(pt, reverse_v_fn(add_accel_fn(d)), TPKB_MOUSEEVENTF_WHEEL, 0, 0);
+static void send_direct_v_wheel(const ScrollPlan *p, POINT pt, int d) {
+    scroll_send_input(pt, p->reverse_v_fn(p->add_accel_fn(p, d)), TPKB_MOUSEEVENTF_WHEEL, 0, 0);
 }
 
-static void send_direct_h_wheel(POINT pt, int d) {
-    scroll_send_input(pt, reverse_h_fn(add_accel_fn(d)), TPKB_MOUSEEVENTF_HWHEEL, 0, 0);
+static void send_direct_h_wheel(const ScrollPlan *p, POINT pt, int d) {
+    scroll_send_input(pt, p->reverse_h_fn(p->add_accel_fn(p, d)), TPKB_MOUSEEVENTF_HWHEEL, 0, 0);
 }
 
-static void (*send_v_wheel)(POINT, int) = send_direct_v_wheel;
-static void (*send_h_wheel)(POINT, int) = send_direct_h_wheel;
-
 /* VH adjuster */
-static VHDirection fixed_vhd, latest_vhd;
-static int switching_threshold_val;
-
-static VHDirection get_first_vhd(int adx, int ady) {
-    int mthr = cfg_get_first_min_threshold();
+static VHDirection get_first_vhd(const ScrollPlan *p, int adx, int ady) {
+    int mthr = p->first_min_threshold;
     if (adx > mthr || ady > mthr) {
-        int y = cfg_is_first_prefer_vertical() ? ady * 2 : ady;
+        int y = p->first_prefer_vertical ? ady * 2 : ady;
         return y >= adx ? VHD_VERTICAL : VHD_HORIZONTAL;
     }
     return VHD_NONE;
 }
 
-static VHDirection switch_vhd(int adx, int ady) {
-    if (ady > switching_threshold_val) return VHD_VERTICAL;
-    if (adx > switching_threshold_val) return VHD_HORIZONTAL;
+static VHDirection switch_vhd(const ScrollPlan *p, int adx, int ady) {
+    if (ady > p->switching_threshold) return VHD_VERTICAL;
+    if (adx > p->switching_threshold) return VHD_HORIZONTAL;
     return VHD_NONE;
 }
 
-static VHDirection switch_vhd_fixed(int adx, int ady) {
-    (void)adx; (void)ady;
+static VHDirection switch_vhd_fixed(const ScrollPlan *p, int adx, int ady) {
+    (void)p; (void)adx; (void)ady;
     return fixed_vhd;
 }
 
-static VHDirection (*switch_vhd_fn)(int, int) = switch_vhd;
-
-static void change_cursor_vhd(VHDirection vhd) {
-    if (cfg_is_cursor_change()) {
+static void change_cursor_vhd(const ScrollPlan *p, VHDirection vhd) {
+    if (p->cursor_change) {
         if (vhd == VHD_VERTICAL) cursor_change_v();
         else if (vhd == VHD_HORIZONTAL) cursor_change_h();
     }
 }
 
-static void send_wheel_vha(POINT wspt, int dx, int dy, int fdx, int fdy) {
+static void send_wheel_vha(const ScrollPlan *p, POINT wspt, int dx, int dy, int fdx, int fdy) {
     int adx = abs(dx), ady = abs(dy);
     VHDirection cur_vhd;
 
     if (fixed_vhd == VHD_NONE) {
-        fixed_vhd = get_first_vhd(adx, ady);
+        fixed_vhd = get_first_vhd(p, adx, ady);
         cur_vhd = fixed_vhd;
     } else {
-        cur_vhd = switch_vhd_fn(adx, ady);
+        cur_vhd = p->switch_vhd_fn(p, adx, ady);
     }
 
     if (cur_vhd != VHD_NONE && cur_vhd != latest_vhd) {
-        change_cursor_vhd(cur_vhd);
+        change_cursor_vhd(p, cur_vhd);
         latest_vhd = cur_vhd;
     }
 
-    if (latest_vhd == VHD_VERTICAL && fdy != 0) send_v_wheel(wspt, fdy);
-    else if (latest_vhd == VHD_HORIZONTAL && fdx != 0) send_h_wheel(wspt, fdx);
+    if (latest_vhd == VHD_VERTICAL && fdy != 0) p->send_v_wheel(p, wspt, fdy);
+    else if (latest_vhd == VHD_HORIZONTAL && fdx != 0) p->send_h_wheel(p, wspt, fdx);
 }
 
-/* Standard mode thresholds */
-static int vert_thr, horiz_thr;
-static BOOL horiz_enabled;
-
-static void send_wheel_std(POINT wspt, int dx, int dy, int fdx, int fdy) {
-    if (abs(dy) > vert_thr && fdy != 0) send_v_wheel(wspt, fdy);
-    if (horiz_enabled && abs(dx) > horiz_thr && fdx != 0) send_h_wheel(wspt, fdx);
+static void send_wheel_std(const ScrollPlan *p, POINT wspt, int dx, int dy, int fdx, int fdy) {
+    if (abs(dy) > p->vert_thr && fdy != 0) p->send_v_wheel(p, wspt, fdy);
+    if (p->horiz_enabled && abs(dx) > p->horiz_thr && fdx != 0) p->send_h_wheel(p, wspt, fdx);
 }
 
-static void (*send_wheel_fn)(POINT, int, int, int, int) = send_wheel_std;
-
 /* ========== Public scroll function ========== */
 
-static void send_wheel_raw(int x, int y) {
-    if (x != 0 || y != 0) {
-        EnterCriticalSection(&g_scroll_state_cs);
-        raw_total_x += x;
-        raw_total_y += y;
-        int dx = raw_total_x, dy = raw_total_y;
-        int ssx = scroll_start_x, ssy = scroll_start_y;
-        LeaveCriticalSection(&g_scroll_state_cs);
-        int fdx = x, fdy = y;
-        if (swap_enabled) { int t = dx; dx = dy; dy = t; t = fdx; fdx = fdy; fdy = t; }
-        POINT wspt;
-        wspt.x = ssx;
-        wspt.y = ssy;
-        send_wheel_fn(wspt, dx, dy, fdx, fdy);
-    }
+/* One lock round trip per batch: running totals are computed up front */
+/* Reader thread: a reused slot must not inherit the old device's totals */
+static void reset_device(int dev) {
+    EnterCriticalSection(&g_scroll_state_cs);
+    raw_total_x[dev] = 0;
+    raw_total_y[dev] = 0;
+    LeaveCriticalSection(&g_scroll_state_cs);
 }
 
-/* ========== Init scroll (called when entering scroll mode) ========== */
+static void send_wheel_raw(int dev, const LONG *xs, const LONG *ys, int count) {
+    int tx[RAW_BATCH_MAX], ty[RAW_BATCH_MAX];
+    if (count > RAW_BATCH_MAX) count = RAW_BATCH_MAX;
 
-void scroll_init_scroll(void) {
     EnterCriticalSection(&g_scroll_state_cs);
-    cfg_get_scroll_start_point(&scroll_start_x, &scroll_start_y);
-    raw_total_x = 0;
-    raw_total_y = 0;
+    ScrollPlan *p = plan_ref(g_session_plan);
+    int total_x = raw_total_x[dev], total_y = raw_total_y[dev];
+    for (int i = 0; i < count; i++) {
+        total_x += xs[i];
+        total_y += ys[i];
+        tx[i] = total_x;
+        ty[i] = total_y;
+    }
+    raw_total_x[dev] = total_x;
+    raw_total_y[dev] = total_y;
+    POINT wspt;
+    wspt.x = scroll_start_x;
+    wspt.y = scroll_start_y;
     LeaveCriticalSection(&g_scroll_state_cs);
+    if (!p) return;
+
+    if (p->use_batch) {
+        int v[RAW_BATCH_MAX], h[RAW_BATCH_MAX];
+        batch_map(&p->batch, xs, ys, tx, ty, count, v, h);
+        for (int i = 0; i < count; i++) {
+            if (v[i]) scroll_send_input(wspt, v[i], TPKB_MOUSEEVENTF_WHEEL, 0, 0);
+            if (h[i]) scroll_send_input(wspt, h[i], TPKB_MOUSEEVENTF_HWHEEL, 0, 0);
+        }
+    } else {
+        for (int i = 0; i < count; i++) {
+            if (xs[i] == 0 && ys[i] == 0) continue;
+            int dx = tx[i], dy = ty[i];
+            int fdx = xs[i], fdy = ys[i];
+            if (p->swap) { int t = dx; dx = dy; dy = t; t = fdx; fdx = fdy; fdy = t; }
+            p->send_wheel_fn(p, wspt, dx, dy, fdx, fdy);
+        }
+    }
+    plan_release(p);
+}
+
+/* ========== Plan build and publication ========== */
 
-    /* Function pointers */
-    add_accel_fn = cfg_is_accel_table() ? add_accel : pass_int;
-    swap_enabled = cfg_is_swap_scroll();
-    reverse_v_fn = cfg_is_reverse_scroll() ? pass_int : flip_int;
-    reverse_h_fn = cfg_is_reverse_scroll() ? flip_int : pass_int;
+static ScrollPlan *build_plan(int key_opts) {
+    ScrollPlan *p = (ScrollPlan *)calloc(1, sizeof(ScrollPlan));
+    if (!p) return NULL;
+    p->refs = 1;    /* g_plan's */
 
-    send_v_wheel = cfg_is_real_wheel_mode() ? send_real_v_wheel : send_direct_v_wheel;
-    send_h_wheel = cfg_is_real_wheel_mode() ? send_real_h_wheel : send_direct_h_wheel;
+    /* Generation first: a change racing the reads below makes the plan stale */
+    p->generation = cfg_get_generation();
+    p->key_opts = key_opts;
 
-    send_wheel_fn = (cfg_is_horizontal_scroll() && cfg_is_vh_adjuster_mode()) ?
-                    send_wheel_vha : send_wheel_std;
+    /* Per trigger key options flip the global settings */
+    BOOL reverse = cfg_is_reverse_scroll() != ((key_opts & KO_REVERSE) != 0);
+    BOOL real_wheel = cfg_is_real_wheel_mode();
+    BOOL vha = cfg_is_vh_adjuster_mode();
 
-    /* Acceleration */
+    p->add_accel_fn = pass_accel;
     if (cfg_is_accel_table()) {
-        accel_threshold = cfg_get_accel_threshold(&accel_count);
-        accel_multiplier = cfg_get_accel_multiplier(&accel_count);
+        int n;
+        const int *thr = cfg_get_accel_threshold(&n);
+        const double *mul = cfg_get_accel_multiplier(&n);
+        if (n > PLAN_ACCEL_MAX) n = PLAN_ACCEL_MAX;
+        if (n > 0) {
+            memcpy(p->accel_threshold, thr, n * sizeof(int));
+            memcpy(p->accel_multiplier, mul, n * sizeof(double));
+            p->accel_count = n;
+            p->add_accel_fn = add_accel;
+        }
     }
+    p->swap = cfg_is_swap_scroll() != ((key_opts & KO_SWAP) != 0);
+    p->reverse_v_fn = reverse ? pass_int : flip_int;
+    p->reverse_h_fn = reverse ? flip_int : pass_int;
+    p->reverse_delta_fn = reverse ? flip_int : pass_int;
+
+    p->send_v_wheel = real_wheel ? send_real_v_wheel : send_direct_v_wheel;
+    p->send_h_wheel = real_wheel ? send_real_h_wheel : send_direct_h_wheel;
+    p->send_wheel_fn = (cfg_is_horizontal_scroll() && vha) ? send_wheel_vha : send_wheel_std;
+
+    p->v_wheel_move = cfg_get_v_wheel_move();
+    p->h_wheel_move = cfg_get_h_wheel_move();
+    p->quick_turn = cfg_is_quick_turn();
+    p->quick_first = cfg_is_quick_first();
+    p->wheel_delta = cfg_get_wheel_delta();
+
+    p->switching_threshold = cfg_get_switching_threshold();
+    p->first_min_threshold = cfg_get_first_min_threshold();
+    p->first_prefer_vertical = cfg_is_first_prefer_vertical();
+    p->switch_vhd_fn = cfg_is_vh_adjuster_switching() ? switch_vhd : switch_vhd_fixed;
+    p->cursor_change = cfg_is_cursor_change();
+
+    p->vert_thr = cfg_get_vertical_threshold();
+    p->horiz_thr = cfg_get_horizontal_threshold();
+    p->horiz_enabled = cfg_is_horizontal_scroll();
+
+    p->use_batch = !real_wheel && !vha;
+    if (p->use_batch)
+        batch_prepare(&p->batch, p->accel_threshold, p->accel_multiplier,
+                      p->accel_count, reverse, p->swap,
+                      p->vert_thr, p->horiz_thr, p->horiz_enabled);
+    return p;
+}
 
-    /* Real wheel mode */
-    if (cfg_is_real_wheel_mode()) {
-        v_wheel_move = cfg_get_v_wheel_move();
-        h_wheel_move = cfg_get_h_wheel_move();
-        quick_turn = cfg_is_quick_turn();
-        wheel_delta = cfg_get_wheel_delta();
-        reverse_delta_fn = cfg_is_reverse_scroll() ? flip_int : pass_int;
-        vw_count = cfg_is_quick_first() ? v_wheel_move : v_wheel_move / 2;
-        hw_count = cfg_is_quick_first() ? h_wheel_move : h_wheel_move / 2;
-        v_last_move = DIR_ZERO;
-        h_last_move = DIR_ZERO;
-    }
+/* Current plan for key_opts, rebuilt if settings changed. Caller holds the lock. */
+static ScrollPlan *current_plan(int key_opts, BOOL *built) {
+    ScrollPlan *p = g_plan;
+    *built = FALSE;
+    if (p && p->generation == cfg_get_generation() && p->key_opts == key_opts)
+        return p;
+
+    ScrollPlan *fresh = build_plan(key_opts);
+    if (!fresh) return p;
+    *built = TRUE;
+    InterlockedExchangePointer((volatile PVOID *)&g_plan, fresh);
+    plan_release(p);    /* freed here unless a session or batch holds it */
+    return fresh;
+}
 
-    /* VH adjuster */
-    if (cfg_is_vh_adjuster_mode()) {
-        fixed_vhd = VHD_NONE;
-        latest_vhd = VHD_NONE;
-        switching_threshold_val = cfg_get_switching_threshold();
-        switch_vhd_fn = cfg_is_vh_adjuster_switching() ? switch_vhd : switch_vhd_fixed;
-    } else {
-        vert_thr = cfg_get_vertical_threshold();
-        horiz_thr = cfg_get_horizontal_threshold();
-        horiz_enabled = cfg_is_horizontal_scroll();
+/* ========== Init scroll (called when entering scroll mode) ========== */
+
+/*
+ * A candidate trigger down (cfg_prepare_scroll) builds the plan ahead of
+ * confirmation; mouse triggers carry no per-key options.
+ */
+static void scroll_prepare_scroll(void) {
+    BOOL built;
+    EnterCriticalSection(&g_scroll_state_cs);
+    current_plan(0, &built);
+    LeaveCriticalSection(&g_scroll_state_cs);
+}
+
+void scroll_init_scroll(void) {
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    int key_opts = cfg_get_scroll_key_options();
+
+    EnterCriticalSection(&g_scroll_state_cs);
+    BOOL built;
+    ScrollPlan *p = current_plan(key_opts, &built);
+    plan_release((ScrollPlan *)InterlockedExchangePointer((volatile PVOID *)&g_session_plan,
+                                                          plan_ref(p)));
+
+    /* Per-session counters */
+    cfg_get_scroll_start_point(&scroll_start_x, &scroll_start_y);
+    memset(raw_total_x, 0, sizeof(raw_total_x));
+    memset(raw_total_y, 0, sizeof(raw_total_y));
+    if (p) {
+        vw_count = p->quick_first ? p->v_wheel_move : p->v_wheel_move / 2;
+        hw_count = p->quick_first ? p->h_wheel_move : p->h_wheel_move / 2;
     }
+    v_last_move = DIR_ZERO;
+    h_last_move = DIR_ZERO;
+    fixed_vhd = VHD_NONE;
+    latest_vhd = VHD_NONE;
+
+    g_confirm_time = now.QuadPart;
+    InterlockedExchange(&g_first_wheel_pending, built ? FIRST_WHEEL_COLD : FIRST_WHEEL_WARM);
+    LeaveCriticalSection(&g_scroll_state_cs);
+}
+
+/* Session exit: batches still in flight keep their own references */
+static void scroll_exit_scroll(void) {
+    EnterCriticalSection(&g_scroll_state_cs);
+    ScrollPlan *p = (ScrollPlan *)InterlockedExchangePointer((volatile PVOID *)&g_session_plan, NULL);
+    LeaveCriticalSection(&g_scroll_state_cs);
+    plan_release(p);
+}
+
+/* ========== Time to first wheel event ========== */
+
+void scroll_first_wheel_report(void) {
+    util_stat_report(&g_first_wheel[FIRST_WHEEL_WARM - 1], L"first wheel (prepared)", L"us");
+    util_stat_report(&g_first_wheel[FIRST_WHEEL_COLD - 1], L"first wheel (cold)", L"us");
 }
 
 /* ========== Init (called once at startup) ========== */
@@ -412,10 +652,10 @@ void scroll_init(void) {
     InitializeCriticalSection(&g_iq_cs);
     InitializeCriticalSection(&g_scroll_state_cs);
 
-    add_accel_fn = pass_int;
-    reverse_v_fn = flip_int;
-    reverse_h_fn = pass_int;
-    reverse_delta_fn = flip_int;
+    LARGE_INTEGER f;
+    QueryPerformanceFrequency(&f);
+    g_qpf = f.QuadPart;
+    g_send_timer = util_create_precise_timer();
 
     /* Start sender thread */
     g_iq_sem = CreateSemaphoreW(NULL, 0, INPUT_QUEUE_SIZE, NULL);
@@ -424,11 +664,16 @@ void scroll_init(void) {
     g_sender_thread = (HANDLE)_beginthreadex(NULL, 0, sender_proc, NULL, 0, NULL);
     SetThreadPriority(g_sender_thread, THREAD_PRIORITY_ABOVE_NORMAL);
 
+    batch_init();
+
     /* Register raw input callback */
     rawinput_set_send_wheel_raw(send_wheel_raw);
+    rawinput_set_device_reset(reset_device);
 
     /* Register scroll init callback */
     cfg_set_init_scroll_cb(scroll_init_scroll);
+    cfg_set_exit_scroll_cb(scroll_exit_scroll);
+    cfg_set_prepare_scroll_cb(scroll_prepare_scroll);
 }
 
 void scroll_cleanup(void) {
@@ -441,6 +686,12 @@ void scroll_cleanup(void) {
     }
     if (g_iq_sem) { CloseHandle(g_iq_sem); g_iq_sem = NULL; }
     if (g_iq_space_sem) { CloseHandle(g_iq_space_sem); g_iq_space_sem = NULL; }
+    if (g_send_timer) { CloseHandle(g_send_timer); g_send_timer = NULL; }
     DeleteCriticalSection(&g_iq_cs);
+
+    /* Raw input is stopped by now: no sender can hold a plan */
+    scroll_exit_scroll();
+    plan_release(g_plan);
+    g_plan = NULL;
 }
 
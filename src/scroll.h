@@ -23,6 +23,7 @@ void scroll_send_input(POINT pt, int data, int flags, DWORD time, DWORD extra);
 void scroll_resend_click(MouseClickType type, const MSLLHOOKSTRUCT *info);
 void scroll_resend_down(const MouseEvent *me);
 void scroll_resend_up(const MouseEvent *me);
+void scroll_resend_up_delayed(const MouseEvent *me, DWORD delay);
 
 /* Modifier key detection */
 BOOL scroll_check_shift(void);
@@ -33,4 +34,7 @@ BOOL scroll_check_esc(void);
 /* Scroll wheel simulation */
 void scroll_init_scroll(void);
 
+/* Trigger confirmation to first wheel event, prepared vs cold plan (us) */
+void scroll_first_wheel_report(void);
+
 #endif
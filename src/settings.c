@@ -9,6 +9,9 @@
 #include "hook.h"
 #include "tray.h"
 #include "dialog.h"
+#include "vkcode.h"
+#include "sysparam.h"
+#include "rawinput.h"
 #include "../res/resource.h"
 #include <commctrl.h>
 #include <shellapi.h>
@@ -196,10 +199,18 @@ static void general_init(HWND hDlg) {
     HWND hVK = GetDlgItem(hDlg, IDC_VK_COMBO);
     SendMessageW(hVK, CB_RESETCONTENT, 0, 0);
     int cur_vk = cfg_get_target_vk_code();
-    int vk_sel = 0;
-    for (int i = 0; i < VK_ENTRY_COUNT; i++) {
-        SendMessageW(hVK, CB_ADDSTRING, 0, (LPARAM)VK_TABLE[i].name);
-        if (VK_TABLE[i].code == cur_vk) vk_sel = i;
+    int vk_sel = -1;
+    for (int i = 0; i < VK_TRIGGER_COUNT; i++) {
+        int idx = (int)SendMessageW(hVK, CB_ADDSTRING, 0, (LPARAM)vk_name_from_code(VK_TRIGGER_CODES[i]));
+        SendMessageW(hVK, CB_SETITEMDATA, idx, VK_TRIGGER_CODES[i]);
+        if (VK_TRIGGER_CODES[i] == cur_vk) vk_sel = idx;
+    }
+    if (vk_sel < 0) {
+        /* Primary key set in the INI file but not in the list */
+        wchar_t name[32];
+        vk_format_name(cur_vk, name, 32);
+        vk_sel = (int)SendMessageW(hVK, CB_ADDSTRING, 0, (LPARAM)name);
+        SendMessageW(hVK, CB_SETITEMDATA, vk_sel, cur_vk);
     }
     SendMessageW(hVK, CB_SETCURSEL, vk_sel, 0);
 
@@ -236,11 +247,18 @@ static BOOL general_apply(HWND hDlg) {
     /* Keyboard */
     BOOL kb = IsDlgButtonChecked(hDlg, IDC_KEYBOARD_ENABLE) == BST_CHECKED;
     cfg_set_boolean(L"keyboardHook", kb);
-    hook_set_or_unset_keyboard(kb);
+    hook_set_or_unset_keyboard(cfg_is_keyboard_hook_needed());
 
+    /* Replace the key list only if the primary key changed */
     int vk_sel = (int)SendDlgItemMessageW(hDlg, IDC_VK_COMBO, CB_GETCURSEL, 0, 0);
-    if (vk_sel >= 0 && vk_sel < VK_ENTRY_COUNT)
-        cfg_set_vk_code_name(VK_TABLE[vk_sel].name);
+    if (vk_sel >= 0) {
+        int vk = (int)SendDlgItemMessageW(hDlg, IDC_VK_COMBO, CB_GETITEMDATA, vk_sel, 0);
+        if (vk != cfg_get_target_vk_code()) {
+            wchar_t name[32];
+            vk_format_name(vk, name, 32);
+            cfg_set_vk_code_name(name);
+        }
+    }
 
     /* Priority */
     int prio_sel = (int)SendDlgItemMessageW(hDlg, IDC_PRIORITY_COMBO, CB_GETCURSEL, 0, 0);
@@ -765,18 +783,12 @@ static void keyboard_init(HWND hDlg) {
     g_initializing = TRUE;
 
     /* Read current keyboard repeat settings */
-    int kb_delay = 1;
-    SystemParametersInfoW(SPI_GETKEYBOARDDELAY, 0, &kb_delay, 0);
-    set_spin_range(hDlg, IDC_KB_DELAY_SPIN, 0, 3, kb_delay);
-
-    DWORD kb_speed = 31;
-    SystemParametersInfoW(SPI_GETKEYBOARDSPEED, 0, &kb_speed, 0);
-    set_spin_range(hDlg, IDC_KB_SPEED_SPIN, 0, 31, (int)kb_speed);
+    set_spin_range(hDlg, IDC_KB_DELAY_SPIN, 0, 3, sysparam_get_keyboard_delay());
+    set_spin_range(hDlg, IDC_KB_SPEED_SPIN, 0, 31, sysparam_get_keyboard_speed());
 
     /* Read current filter keys state */
-    FILTERKEYS fk = {0};
-    fk.cbSize = sizeof(FILTERKEYS);
-    SystemParametersInfoW(SPI_GETFILTERKEYS, sizeof(FILTERKEYS), &fk, 0);
+    FILTERKEYS fk;
+    sysparam_get_filter_keys(&fk);
 
     BOOL enabled = (fk.dwFlags & FKF_FILTERKEYSON) != 0;
     CheckDlgButton(hDlg, IDC_FK_ENABLE, enabled ? BST_CHECKED : BST_UNCHECKED);
@@ -806,10 +818,8 @@ static BOOL keyboard_apply(HWND hDlg) {
     cfg_set_number(L"kbRepeatDelay", kb_delay);
     cfg_set_number(L"kbRepeatSpeed", kb_speed);
 
-    SystemParametersInfoW(SPI_SETKEYBOARDDELAY, (UINT)kb_delay, NULL,
-                          SPIF_UPDATEINIFILE | SPIF_SENDCHANGE);
-    SystemParametersInfoW(SPI_SETKEYBOARDSPEED, (UINT)kb_speed, NULL,
-                          SPIF_UPDATEINIFILE | SPIF_SENDCHANGE);
+    sysparam_set_keyboard_delay(kb_delay);
+    sysparam_set_keyboard_speed(kb_speed);
 
     /* Filter Keys */
     int accept, delay, repeat, bounce;
@@ -842,11 +852,8 @@ static BOOL keyboard_apply(HWND hDlg) {
         fk.iRepeatMSec = 500;
         fk.iBounceMSec = 0;
     }
-    SystemParametersInfoW(SPI_SETFILTERKEYS, sizeof(FILTERKEYS), &fk,
-                          SPIF_UPDATEINIFILE | SPIF_SENDCHANGE);
-
-    if (!enabled)
-        fk_delete_last_registry_values();
+    /* Registry cleanup must follow the write, so it runs on the worker */
+    sysparam_set_filter_keys(&fk, enabled ? NULL : fk_delete_last_registry_values);
 
     return TRUE;
 }
@@ -906,6 +913,10 @@ static INT_PTR CALLBACK keyboard_proc(HWND hDlg, UINT msg, WPARAM wParam, LPARAM
     return FALSE;
 }
 
+void settings_refresh(void) {
+    refresh_all_pages();
+}
+
 void settings_apply_filter_keys(void) {
     BOOL lock = cfg_get_boolean(L"fkLock");
 
@@ -913,23 +924,16 @@ void settings_apply_filter_keys(void) {
     if (lock) {
         int cfg_kb_delay = cfg_get_number(L"kbRepeatDelay");
         int cfg_kb_speed = cfg_get_number(L"kbRepeatSpeed");
-        int sys_kb_delay = 1;
-        DWORD sys_kb_speed = 31;
-        SystemParametersInfoW(SPI_GETKEYBOARDDELAY, 0, &sys_kb_delay, 0);
-        SystemParametersInfoW(SPI_GETKEYBOARDSPEED, 0, &sys_kb_speed, 0);
-
-        if (sys_kb_delay != cfg_kb_delay)
-            SystemParametersInfoW(SPI_SETKEYBOARDDELAY, (UINT)cfg_kb_delay, NULL,
-                                  SPIF_UPDATEINIFILE | SPIF_SENDCHANGE);
-        if ((int)sys_kb_speed != cfg_kb_speed)
-            SystemParametersInfoW(SPI_SETKEYBOARDSPEED, (UINT)cfg_kb_speed, NULL,
-                                  SPIF_UPDATEINIFILE | SPIF_SENDCHANGE);
+        /* Effective values: a queued write is not visible to SPI_GET* yet */
+        if (sysparam_get_keyboard_delay() != cfg_kb_delay)
+            sysparam_set_keyboard_delay(cfg_kb_delay);
+        if (sysparam_get_keyboard_speed() != cfg_kb_speed)
+            sysparam_set_keyboard_speed(cfg_kb_speed);
     }
 
     /* Filter Keys */
-    FILTERKEYS fk = {0};
-    fk.cbSize = sizeof(FILTERKEYS);
-    SystemParametersInfoW(SPI_GETFILTERKEYS, sizeof(FILTERKEYS), &fk, 0);
+    FILTERKEYS fk;
+    sysparam_get_filter_keys(&fk);
 
     BOOL sys_enabled = (fk.dwFlags & FKF_FILTERKEYSON) != 0;
     BOOL cfg_enabled = cfg_get_boolean(L"filterKeys");
@@ -952,8 +956,7 @@ void settings_apply_filter_keys(void) {
                 nfk.iDelayMSec = (DWORD)cfg_delay;
                 nfk.iRepeatMSec = (DWORD)cfg_repeat;
                 nfk.iBounceMSec = (DWORD)cfg_bounce;
-                SystemParametersInfoW(SPI_SETFILTERKEYS, sizeof(FILTERKEYS), &nfk,
-                                      SPIF_UPDATEINIFILE | SPIF_SENDCHANGE);
+                sysparam_set_filter_keys(&nfk, NULL);
             }
         } else {
             /* System enabled, lock off → sync system values to config */
@@ -977,8 +980,7 @@ void settings_apply_filter_keys(void) {
             nfk.iDelayMSec = (DWORD)cfg_delay;
             nfk.iRepeatMSec = (DWORD)cfg_repeat;
             nfk.iBounceMSec = (DWORD)cfg_bounce;
-            SystemParametersInfoW(SPI_SETFILTERKEYS, sizeof(FILTERKEYS), &nfk,
-                                  SPIF_UPDATEINIFILE | SPIF_SENDCHANGE);
+            sysparam_set_filter_keys(&nfk, NULL);
         } else {
             /* System disabled, config enabled, lock off → enable with registry values */
             FILTERKEYS nfk = {0};
@@ -988,8 +990,7 @@ void settings_apply_filter_keys(void) {
             nfk.iDelayMSec = fk.iDelayMSec;
             nfk.iRepeatMSec = fk.iRepeatMSec;
             nfk.iBounceMSec = fk.iBounceMSec;
-            SystemParametersInfoW(SPI_SETFILTERKEYS, sizeof(FILTERKEYS), &nfk,
-                                  SPIF_UPDATEINIFILE | SPIF_SENDCHANGE);
+            sysparam_set_filter_keys(&nfk, NULL);
             cfg_set_number(L"fkAcceptanceDelay", (int)fk.iWaitMSec);
             cfg_set_number(L"fkRepeatDelay", (int)fk.iDelayMSec);
             cfg_set_number(L"fkRepeatRate", (int)fk.iRepeatMSec);
@@ -1170,7 +1171,12 @@ void settings_show(void) {
     psh.nPages = 7;
     psh.ppsp = psp;
 
+    /* Hook and WM_INPUT queueing delay while the dialog is open (debug output) */
+    hook_delay_reset();
+    rawinput_delay_reset();
     PropertySheetW(&psh);
+    hook_delay_report(L"hook delay while settings open");
+    rawinput_delay_report(L"WM_INPUT delay while settings open");
 
     memset(g_page_hwnd, 0, sizeof(g_page_hwnd));
     g_settings_open = FALSE;
@@ -10,5 +10,6 @@
 
 void settings_show(void);
 void settings_apply_filter_keys(void);
+void settings_refresh(void);  /* reload open pages from the config */
 
 #endif
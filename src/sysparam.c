@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2026 Li Ruijie
+ * Licensed under the GNU General Public License v3.0.
+ */
+
+#include "sysparam.h"
+#include "util.h"
+#include <process.h>
+
+#define SP_KB_DELAY     0x1
+#define SP_KB_SPEED     0x2
+#define SP_FILTER_KEYS  0x4
+
+#define BROADCAST_TIMEOUT 1000  /* ms per broadcast */
+#define FLUSH_TIMEOUT     5000  /* ms at exit */
+
+typedef struct {
+    DWORD      flags;  /* SP_* fields present */
+    int        kb_delay;
+    int        kb_speed;
+    FILTERKEYS fk;
+    void     (*fk_after)(void);
+} SysParamRequest;
+
+static SysParamRequest g_pending;
+static SysParamRequest g_queued;    /* latest value per field; flags: not yet applied */
+static CRITICAL_SECTION g_sp_cs;
+static HANDLE g_sp_event = NULL;
+static HANDLE g_sp_thread = NULL;
+static volatile BOOL g_sp_running = FALSE;
+
+/* Time per write including its broadcast */
+static LatencyStat g_write_time;
+static LONGLONG g_qpf = 1;
+
+/* Write without SPIF_SENDCHANGE, then notify with a bounded broadcast */
+static void apply(UINT action, UINT ui, void *pv) {
+    LARGE_INTEGER t0, t1;
+    QueryPerformanceCounter(&t0);
+    if (!SystemParametersInfoW(action, ui, pv, SPIF_UPDATEINIFILE)) return;
+    DWORD_PTR res;
+    SendMessageTimeoutW(HWND_BROADCAST, WM_SETTINGCHANGE, action, 0,
+                        SMTO_ABORTIFHUNG | SMTO_NORMAL, BROADCAST_TIMEOUT, &res);
+    QueryPerformanceCounter(&t1);
+    util_stat_add(&g_write_time, (LONG)((t1.QuadPart - t0.QuadPart) * 1000000 / g_qpf));
+}
+
+static BOOL take_pending(SysParamRequest *req) {
+    EnterCriticalSection(&g_sp_cs);
+    *req = g_pending;
+    g_pending.flags = 0;
+    g_pending.fk_after = NULL;
+    LeaveCriticalSection(&g_sp_cs);
+    return req->flags != 0;
+}
+
+/* Fields of req are now in effect, unless queued again meanwhile */
+static void mark_applied(const SysParamRequest *req) {
+    EnterCriticalSection(&g_sp_cs);
+    g_queued.flags &= ~(req->flags & ~g_pending.flags);
+    LeaveCriticalSection(&g_sp_cs);
+}
+
+static unsigned __stdcall sysparam_proc(void *arg) {
+    (void)arg;
+    SysParamRequest req;
+    for (;;) {
+        WaitForSingleObject(g_sp_event, INFINITE);
+        while (take_pending(&req)) {
+            if (req.flags & SP_KB_DELAY)
+                apply(SPI_SETKEYBOARDDELAY, (UINT)req.kb_delay, NULL);
+            if (req.flags & SP_KB_SPEED)
+                apply(SPI_SETKEYBOARDSPEED, (UINT)req.kb_speed, NULL);
+            if (req.flags & SP_FILTER_KEYS) {
+                apply(SPI_SETFILTERKEYS, sizeof(FILTERKEYS), &req.fk);
+                if (req.fk_after) req.fk_after();
+            }
+            mark_applied(&req);
+        }
+        if (!g_sp_running) break;
+    }
+    return 0;
+}
+
+/* Falls back to a synchronous write if the worker is not running */
+static void submit(void) {
+    if (g_sp_thread) {
+        SetEvent(g_sp_event);
+        return;
+    }
+    SysParamRequest req;
+    if (!take_pending(&req)) return;
+    if (req.flags & SP_KB_DELAY)
+        SystemParametersInfoW(SPI_SETKEYBOARDDELAY, (UINT)req.kb_delay, NULL,
+                              SPIF_UPDATEINIFILE | SPIF_SENDCHANGE);
+    if (req.flags & SP_KB_SPEED)
+        SystemParametersInfoW(SPI_SETKEYBOARDSPEED, (UINT)req.kb_speed, NULL,
+                              SPIF_UPDATEINIFILE | SPIF_SENDCHANGE);
+    if (req.flags & SP_FILTER_KEYS) {
+        SystemParametersInfoW(SPI_SETFILTERKEYS, sizeof(FILTERKEYS), &req.fk,
+                              SPIF_UPDATEINIFILE | SPIF_SENDCHANGE);
+        if (req.fk_after) req.fk_after();
+    }
+    mark_applied(&req);
+}
+
+void sysparam_set_keyboard_delay(int delay) {
+    EnterCriticalSection(&g_sp_cs);
+    g_pending.kb_delay = delay;
+    g_pending.flags |= SP_KB_DELAY;
+    g_queued.kb_delay = delay;
+    g_queued.flags |= SP_KB_DELAY;
+    LeaveCriticalSection(&g_sp_cs);
+    submit();
+}
+
+void sysparam_set_keyboard_speed(int speed) {
+    EnterCriticalSection(&g_sp_cs);
+    g_pending.kb_speed = speed;
+    g_pending.flags |= SP_KB_SPEED;
+    g_queued.kb_speed = speed;
+    g_queued.flags |= SP_KB_SPEED;
+    LeaveCriticalSection(&g_sp_cs);
+    submit();
+}
+
+void sysparam_set_filter_keys(const FILTERKEYS *fk, void (*after)(void)) {
+    EnterCriticalSection(&g_sp_cs);
+    g_pending.fk = *fk;
+    g_pending.fk_after = after;
+    g_pending.flags |= SP_FILTER_KEYS;
+    g_queued.fk = *fk;
+    g_queued.flags |= SP_FILTER_KEYS;
+    LeaveCriticalSection(&g_sp_cs);
+    submit();
+}
+
+/*
+ * SystemParametersInfo still reports the old value while a write is
+ * queued; comparing against it would queue the same write again.
+ */
+int sysparam_get_keyboard_delay(void) {
+    int v = 1;
+    EnterCriticalSection(&g_sp_cs);
+    BOOL queued = (g_queued.flags & SP_KB_DELAY) != 0;
+    if (queued) v = g_queued.kb_delay;
+    LeaveCriticalSection(&g_sp_cs);
+    if (!queued) SystemParametersInfoW(SPI_GETKEYBOARDDELAY, 0, &v, 0);
+    return v;
+}
+
+int sysparam_get_keyboard_speed(void) {
+    DWORD v = 31;
+    EnterCriticalSection(&g_sp_cs);
+    BOOL queued = (g_queued.flags & SP_KB_SPEED) != 0;
+    if (queued) v = (DWORD)g_queued.kb_speed;
+    LeaveCriticalSection(&g_sp_cs);
+    if (!queued) SystemParametersInfoW(SPI_GETKEYBOARDSPEED, 0, &v, 0);
+    return (int)v;
+}
+
+void sysparam_get_filter_keys(FILTERKEYS *fk) {
+    EnterCriticalSection(&g_sp_cs);
+    BOOL queued = (g_queued.flags & SP_FILTER_KEYS) != 0;
+    if (queued) *fk = g_queued.fk;
+    LeaveCriticalSection(&g_sp_cs);
+    if (queued) return;
+    ZeroMemory(fk, sizeof(*fk));
+    fk->cbSize = sizeof(FILTERKEYS);
+    SystemParametersInfoW(SPI_GETFILTERKEYS, sizeof(FILTERKEYS), fk, 0);
+}
+
+void sysparam_report(void) {
+    util_stat_report(&g_write_time, L"system parameter write", L"us");
+}
+
+/* ========== Init / cleanup ========== */
+
+void sysparam_init(void) {
+    LARGE_INTEGER f;
+    QueryPerformanceFrequency(&f);
+    g_qpf = f.QuadPart;
+    InitializeCriticalSection(&g_sp_cs);
+    g_sp_event = CreateEventW(NULL, FALSE, FALSE, NULL);
+    if (!g_sp_event) return;
+    g_sp_running = TRUE;
+    g_sp_thread = (HANDLE)_beginthreadex(NULL, 0, sysparam_proc, NULL, 0, NULL);
+}
+
+void sysparam_cleanup(void) {
+    g_sp_running = FALSE;
+    if (g_sp_event) SetEvent(g_sp_event); /* Drain pending, then exit */
+    if (g_sp_thread) {
+        WaitForSingleObject(g_sp_thread, FLUSH_TIMEOUT);
+        CloseHandle(g_sp_thread);
+        g_sp_thread = NULL;
+    }
+    if (g_sp_event) { CloseHandle(g_sp_event); g_sp_event = NULL; }
+}
@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2026 Li Ruijie
+ * Licensed under the GNU General Public License v3.0.
+ */
+
+#ifndef W10WHEEL_SYSPARAM_H
+#define W10WHEEL_SYSPARAM_H
+
+#include <windows.h>
+
+/*
+ * Keyboard repeat and Filter Keys writes, applied on a background worker.
+ * Requests coalesce (latest value wins) and the WM_SETTINGCHANGE broadcast
+ * is timeout-bounded, so a hung window cannot stall the caller.
+ */
+
+void sysparam_init(void);
+void sysparam_cleanup(void);  /* flushes pending writes, bounded */
+
+void sysparam_set_keyboard_delay(int delay);
+void sysparam_set_keyboard_speed(int speed);
+
+/* after: optional, run on the worker once the write is done */
+void sysparam_set_filter_keys(const FILTERKEYS *fk, void (*after)(void));
+
+/* Effective values: the latest queued write, else the current system value */
+int  sysparam_get_keyboard_delay(void);
+int  sysparam_get_keyboard_speed(void);
+void sysparam_get_filter_keys(FILTERKEYS *fk);
+
+/* Write durations, via OutputDebugStringW */
+void sysparam_report(void);
+
+#endif
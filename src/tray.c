@@ -7,14 +7,21 @@
 #include "types.h"
 #include "config.h"
 #include "hook.h"
+#include "kevent.h"
 #include "ipc.h"
 #include "settings.h"
+#include "cfgwatch.h"
+#include "cfgstore.h"
 #include "../res/resource.h"
 #include <shellapi.h>
 #include <shlobj.h>
 #include <stdio.h>
 
 #define TIMER_HOOK_HEALTH 1
+#define ENDSESSION_FLUSH  1000  /* ms */
+
+/* Posted by the config watcher once the active profile file settles */
+#define WM_CONFIG_CHANGED (WM_APP + 2)
 
 enum {
     IDM_PASS_MODE = 1,
@@ -36,6 +43,11 @@ static HMENU build_context_menu(void) {
 
     AppendMenuW(menu, MF_GRAYED, 0,
                 IsUserAnAdmin() ? L"Running as Admin" : L"Running as User");
+    if (cfg_is_debounce()) {
+        wchar_t chatter[64];
+        _snwprintf(chatter, 64, L"Chatter suppressed: %ld", (long)kevent_chatter_total());
+        AppendMenuW(menu, MF_GRAYED, 0, chatter);
+    }
     AppendMenuW(menu, MF_SEPARATOR, 0, NULL);
     AppendMenuW(menu, cfg_is_pass_mode() ? MF_CHECKED : MF_UNCHECKED,
                 IDM_PASS_MODE, cfg_is_pass_mode() ? L"Stopped" : L"Runnable");
@@ -65,6 +77,25 @@ static void handle_command(int cmd_id) {
     }
 }
 
+/* ========== Config file changes ========== */
+
+/* Only what the new snapshot actually changed is redone */
+static void reload_config(void) {
+    LONG gen = cfg_get_generation();
+    BOOL kb = cfg_is_keyboard_hook_needed();
+    int health = cfg_get_hook_health_check();
+
+    cfg_reload_properties();
+    if (cfg_get_generation() == gen) return;
+
+    if (cfg_is_keyboard_hook_needed() != kb)
+        hook_set_or_unset_keyboard(!kb);
+    if (cfg_get_hook_health_check() != health)
+        tray_update_health_timer();
+    settings_apply_filter_keys();  /* writes only what differs from the system */
+    settings_refresh();
+}
+
 /* ========== Window procedure ========== */
 
 static LRESULT CALLBACK tray_wnd_proc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
@@ -87,7 +118,9 @@ static LRESULT CALLBACK tray_wnd_proc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM
             GetCursorPos(&pt);
             BOOL moved = (pt.x != g_last_pt.x || pt.y != g_last_pt.y);
             g_last_pt = pt;
-            if (moved && !InterlockedExchange(&g_hook_alive, FALSE))  {
+            /* Skip while the mouse hook is intentionally uninstalled */
+            if (moved && cfg_is_mouse_hook_needed() &&
+                !InterlockedExchange(&g_hook_alive, FALSE))  {
                 hook_unhook_mouse();
                 hook_set_mouse();
             }
@@ -98,13 +131,20 @@ static LRESULT CALLBACK tray_wnd_proc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM
         ipc_proc_message((int)wParam);
         return 0;
 
+    case WM_CONFIG_CHANGED:
+        reload_config();
+        return 0;
+
     case WM_COMMAND:
         handle_command(LOWORD(wParam));
         return 0;
 
     case WM_ENDSESSION:
-        if (wParam)
+        /* Queued to the writer; the wait is bounded by the shutdown budget */
+        if (wParam) {
             cfg_store_properties();
+            cfgstore_flush(ENDSESSION_FLUSH);
+        }
         return 0;
 
     case WM_DESTROY:
@@ -160,10 +200,14 @@ HWND tray_init(HINSTANCE hInst) {
     _snwprintf(g_nid.szTip, 128, L"%s - %s", PROGRAM_NAME, L"Runnable");
     Shell_NotifyIconW(NIM_ADD, &g_nid);
 
+    /* Hot reload of the active profile; without it edits need a reload */
+    if (g_hwnd) cfgwatch_start(g_hwnd, WM_CONFIG_CHANGED);
+
     return g_hwnd;
 }
 
 void tray_cleanup(void) {
+    cfgwatch_stop();
     Shell_NotifyIconW(NIM_DELETE, &g_nid);
     if (g_hwnd) DestroyWindow(g_hwnd);
 }
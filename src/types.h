@@ -8,6 +8,7 @@
 
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
+#include "lastflags.h"   /* LastFlags (event tracking) */
 
 /* ========== Application constants ========== */
 
@@ -227,54 +228,6 @@ static inline const double *accel_preset_array(AccelPreset p) {
     return ACCEL_M5;
 }
 
-/* ========== VK code table (keyboard triggers) ========== */
-
-typedef struct {
-    const wchar_t *name;
-    int code;
-} VKEntry;
-
-#define VK_ENTRY_COUNT 24
-
-static const VKEntry VK_TABLE[VK_ENTRY_COUNT] = {
-    { L"None",           0x00 },
-    { L"VK_TAB",         0x09 },
-    { L"VK_PAUSE",       0x13 },
-    { L"VK_CAPITAL",     0x14 },
-    { L"VK_CONVERT",     0x1C },
-    { L"VK_NONCONVERT",  0x1D },
-    { L"VK_PRIOR",       0x21 },
-    { L"VK_NEXT",        0x22 },
-    { L"VK_END",         0x23 },
-    { L"VK_HOME",        0x24 },
-    { L"VK_SNAPSHOT",    0x2C },
-    { L"VK_INSERT",      0x2D },
-    { L"VK_DELETE",      0x2E },
-    { L"VK_LWIN",        0x5B },
-    { L"VK_RWIN",        0x5C },
-    { L"VK_APPS",        0x5D },
-    { L"VK_NUMLOCK",     0x90 },
-    { L"VK_SCROLL",      0x91 },
-    { L"VK_LSHIFT",      0xA0 },
-    { L"VK_RSHIFT",      0xA1 },
-    { L"VK_LCONTROL",    0xA2 },
-    { L"VK_RCONTROL",    0xA3 },
-    { L"VK_LMENU",       0xA4 },
-    { L"VK_RMENU",       0xA5 },
-};
-
-static inline int vk_code_from_name(const wchar_t *name) {
-    for (int i = 0; i < VK_ENTRY_COUNT; i++)
-        if (wcscmp(VK_TABLE[i].name, name) == 0) return VK_TABLE[i].code;
-    return 0;
-}
-
-static inline const wchar_t *vk_name_from_code(int code) {
-    for (int i = 0; i < VK_ENTRY_COUNT; i++)
-        if (VK_TABLE[i].code == code) return VK_TABLE[i].name;
-    return L"None";
-}
-
 /* ========== Trigger string table ========== */
 
 typedef struct {
@@ -364,13 +317,4 @@ static inline AccelPreset accel_preset_from_name(const wchar_t *name) {
     return ACCEL_PRESET_M5;
 }
 
-/* ========== LastFlags (event tracking) ========== */
-
-typedef struct {
-    volatile BOOL ld_resent, rd_resent;
-    volatile BOOL ld_passed, rd_passed;
-    volatile BOOL ld_suppressed, rd_suppressed, sd_suppressed;
-    volatile BOOL kd_suppressed[256];
-} LastFlags;
-
 #endif /* TPKB_TYPES_H */
@@ -132,3 +132,47 @@ void util_get_last_error_message(wchar_t *buf, int bufsize) {
     FormatMessageW(FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS,
                    NULL, err, 0, buf, bufsize, NULL);
 }
+
+/* ========== Precise timer ========== */
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+HANDLE util_create_precise_timer(void) {
+    HANDLE t = CreateWaitableTimerExW(NULL, NULL,
+        CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if (!t) /* before Windows 10 1803 */
+        t = CreateWaitableTimerW(NULL, FALSE, NULL);
+    return t;
+}
+
+/* ========== Latency statistics ========== */
+
+void util_stat_reset(LatencyStat *s) {
+    InterlockedExchange(&s->count, 0);
+    InterlockedExchange(&s->max, 0);
+    InterlockedExchange64(&s->sum, 0);
+}
+
+void util_stat_add(LatencyStat *s, LONG value) {
+    if (value < 0) value = 0;
+    InterlockedIncrement(&s->count);
+    InterlockedExchangeAdd64(&s->sum, value);
+    LONG cur = s->max;
+    while (value > cur) {
+        LONG prev = InterlockedCompareExchange(&s->max, value, cur);
+        if (prev == cur) break;
+        cur = prev;
+    }
+}
+
+void util_stat_report(const LatencyStat *s, const wchar_t *label, const wchar_t *unit) {
+    wchar_t buf[256];
+    LONG n = s->count;
+    LONG64 avg = n ? s->sum / n : 0;
+    _snwprintf(buf, 256, L"tpkb: %s: n=%ld avg=%lld%s max=%ld%s\n",
+               label, (long)n, (long long)avg, unit, (long)s->max, unit);
+    buf[255] = L'\0';
+    OutputDebugStringW(buf);
+}
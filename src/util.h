@@ -23,4 +23,18 @@ void util_set_priority(Priority p);
 /* Win32 error message */
 void util_get_last_error_message(wchar_t *buf, int bufsize);
 
+/* Auto-reset waitable timer, high resolution where supported (Windows 10 1803+) */
+HANDLE util_create_precise_timer(void);
+
+/* Latency statistics: lock-free accumulate, report via OutputDebugStringW */
+typedef struct {
+    volatile LONG   count;
+    volatile LONG   max;
+    volatile LONG64 sum;
+} LatencyStat;
+
+void util_stat_reset(LatencyStat *s);
+void util_stat_add(LatencyStat *s, LONG value);
+void util_stat_report(const LatencyStat *s, const wchar_t *label, const wchar_t *unit);
+
 #endif
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2026 Li Ruijie
+ * Licensed under the GNU General Public License v3.0.
+ */
+
+#include "vkcode.h"
+#include <wchar.h>
+#include <stdio.h>
+
+/* Name by code; NULL for reserved / unassigned codes */
+static const wchar_t *const VK_NAMES[256] = {
+    /* 0x00 */ L"None", L"VK_LBUTTON", L"VK_RBUTTON", L"VK_CANCEL",
+    /* 0x04 */ L"VK_MBUTTON", L"VK_XBUTTON1", L"VK_XBUTTON2", NULL,
+    /* 0x08 */ L"VK_BACK", L"VK_TAB", NULL, NULL,
+    /* 0x0C */ L"VK_CLEAR", L"VK_RETURN", NULL, NULL,
+    /* 0x10 */ L"VK_SHIFT", L"VK_CONTROL", L"VK_MENU", L"VK_PAUSE",
+    /* 0x14 */ L"VK_CAPITAL", L"VK_KANA", L"VK_IME_ON", L"VK_JUNJA",
+    /* 0x18 */ L"VK_FINAL", L"VK_KANJI", L"VK_IME_OFF", L"VK_ESCAPE",
+    /* 0x1C */ L"VK_CONVERT", L"VK_NONCONVERT", L"VK_ACCEPT", L"VK_MODECHANGE",
+    /* 0x20 */ L"VK_SPACE", L"VK_PRIOR", L"VK_NEXT", L"VK_END",
+    /* 0x24 */ L"VK_HOME", L"VK_LEFT", L"VK_UP", L"VK_RIGHT",
+    /* 0x28 */ L"VK_DOWN", L"VK_SELECT", L"VK_PRINT", L"VK_EXECUTE",
+    /* 0x2C */ L"VK_SNAPSHOT", L"VK_INSERT", L"VK_DELETE", L"VK_HELP",
+    /* 0x30 */ L"VK_0", L"VK_1", L"VK_2", L"VK_3",
+    /* 0x34 */ L"VK_4", L"VK_5", L"VK_6", L"VK_7",
+    /* 0x38 */ L"VK_8", L"VK_9", NULL, NULL,
+    /* 0x3C */ NULL, NULL, NULL, NULL,
+    /* 0x40 */ NULL, L"VK_A", L"VK_B", L"VK_C",
+    /* 0x44 */ L"VK_D", L"VK_E", L"VK_F", L"VK_G",
+    /* 0x48 */ L"VK_H", L"VK_I", L"VK_J", L"VK_K",
+    /* 0x4C */ L"VK_L", L"VK_M", L"VK_N", L"VK_O",
+    /* 0x50 */ L"VK_P", L"VK_Q", L"VK_R", L"VK_S",
+    /* 0x54 */ L"VK_T", L"VK_U", L"VK_V", L"VK_W",
+    /* 0x58 */ L"VK_X", L"VK_Y", L"VK_Z", L"VK_LWIN",
+    /* 0x5C */ L"VK_RWIN", L"VK_APPS", NULL, L"VK_SLEEP",
+    /* 0x60 */ L"VK_NUMPAD0", L"VK_NUMPAD1", L"VK_NUMPAD2", L"VK_NUMPAD3",
+    /* 0x64 */ L"VK_NUMPAD4", L"VK_NUMPAD5", L"VK_NUMPAD6", L"VK_NUMPAD7",
+    /* 0x68 */ L"VK_NUMPAD8", L"VK_NUMPAD9", L"VK_MULTIPLY", L"VK_ADD",
+    /* 0x6C */ L"VK_SEPARATOR", L"VK_SUBTRACT", L"VK_DECIMAL", L"VK_DIVIDE",
+    /* 0x70 */ L"VK_F1", L"VK_F2", L"VK_F3", L"VK_F4",
+    /* 0x74 */ L"VK_F5", L"VK_F6", L"VK_F7", L"VK_F8",
+    /* 0x78 */ L"VK_F9", L"VK_F10", L"VK_F11", L"VK_F12",
+    /* 0x7C */ L"VK_F13", L"VK_F14", L"VK_F15", L"VK_F16",
+    /* 0x80 */ L"VK_F17", L"VK_F18", L"VK_F19", L"VK_F20",
+    /* 0x84 */ L"VK_F21", L"VK_F22", L"VK_F23", L"VK_F24",
+    /* 0x88 */ NULL, NULL, NULL, NULL,
+    /* 0x8C */ NULL, NULL, NULL, NULL,
+    /* 0x90 */ L"VK_NUMLOCK", L"VK_SCROLL", NULL, NULL,
+    /* 0x94 */ NULL, NULL, NULL, NULL,
+    /* 0x98 */ NULL, NULL, NULL, NULL,
+    /* 0x9C */ NULL, NULL, NULL, NULL,
+    /* 0xA0 */ L"VK_LSHIFT", L"VK_RSHIFT", L"VK_LCONTROL", L"VK_RCONTROL",
+    /* 0xA4 */ L"VK_LMENU", L"VK_RMENU", L"VK_BROWSER_BACK", L"VK_BROWSER_FORWARD",
+    /* 0xA8 */ L"VK_BROWSER_REFRESH", L"VK_BROWSER_STOP", L"VK_BROWSER_SEARCH", L"VK_BROWSER_FAVORITES",
+    /* 0xAC */ L"VK_BROWSER_HOME", L"VK_VOLUME_MUTE", L"VK_VOLUME_DOWN", L"VK_VOLUME_UP",
+    /* 0xB0 */ L"VK_MEDIA_NEXT_TRACK", L"VK_MEDIA_PREV_TRACK", L"VK_MEDIA_STOP", L"VK_MEDIA_PLAY_PAUSE",
+    /* 0xB4 */ L"VK_LAUNCH_MAIL", L"VK_LAUNCH_MEDIA_SELECT", L"VK_LAUNCH_APP1", L"VK_LAUNCH_APP2",
+    /* 0xB8 */ NULL, NULL, L"VK_OEM_1", L"VK_OEM_PLUS",
+    /* 0xBC */ L"VK_OEM_COMMA", L"VK_OEM_MINUS", L"VK_OEM_PERIOD", L"VK_OEM_2",
+    /* 0xC0 */ L"VK_OEM_3", NULL, NULL, NULL,
+    /* 0xC4 */ NULL, NULL, NULL, NULL,
+    /* 0xC8 */ NULL, NULL, NULL, NULL,
+    /* 0xCC */ NULL, NULL, NULL, NULL,
+    /* 0xD0 */ NULL, NULL, NULL, NULL,
+    /* 0xD4 */ NULL, NULL, NULL, NULL,
+    /* 0xD8 */ NULL, NULL, NULL, L"VK_OEM_4",
+    /* 0xDC */ L"VK_OEM_5", L"VK_OEM_6", L"VK_OEM_7", L"VK_OEM_8",
+    /* 0xE0 */ NULL, L"VK_OEM_AX", L"VK_OEM_102", L"VK_ICO_HELP",
+    /* 0xE4 */ NULL, L"VK_PROCESSKEY", NULL, L"VK_PACKET",
+    /* 0xE8 */ NULL, NULL, NULL, NULL,
+    /* 0xEC */ NULL, NULL, NULL, NULL,
+    /* 0xF0 */ NULL, NULL, NULL, NULL,
+    /* 0xF4 */ NULL, NULL, L"VK_ATTN", L"VK_CRSEL",
+    /* 0xF8 */ L"VK_EXSEL", L"VK_EREOF", L"VK_PLAY", L"VK_ZOOM",
+    /* 0xFC */ L"VK_NONAME", L"VK_PA1", L"VK_OEM_CLEAR", NULL,
+};
+
+/* Code by name: open-addressing hash, built once by vk_table_init() */
+#define VK_HASH_SIZE 512    /* power of two, > 2x the named codes */
+
+static short g_vk_hash[VK_HASH_SIZE];
+
+static unsigned vk_hash(const wchar_t *s) {
+    unsigned h = 2166136261u;   /* FNV-1a */
+    while (*s) {
+        h ^= (unsigned)*s++;
+        h *= 16777619u;
+    }
+    return h & (VK_HASH_SIZE - 1);
+}
+
+void vk_table_init(void) {
+    for (int i = 0; i < VK_HASH_SIZE; i++)
+        g_vk_hash[i] = -1;
+    for (int code = 0; code < 256; code++) {
+        if (!VK_NAMES[code]) continue;
+        unsigned h = vk_hash(VK_NAMES[code]);
+        while (g_vk_hash[h] >= 0)
+            h = (h + 1) & (VK_HASH_SIZE - 1);
+        g_vk_hash[h] = (short)code;
+    }
+}
+
+/* Accepts a table name ("VK_APPS") or a hex code ("0x5D"); 0 if unknown */
+int vk_code_from_name(const wchar_t *name) {
+    if (name[0] == L'0' && (name[1] == L'x' || name[1] == L'X')) {
+        wchar_t *end;
+        long v = wcstol(name + 2, &end, 16);
+        return (end != name + 2 && *end == L'\0' && v > 0 && v < 256) ? (int)v : 0;
+    }
+    unsigned h = vk_hash(name);
+    while (g_vk_hash[h] >= 0) {
+        if (wcscmp(VK_NAMES[g_vk_hash[h]], name) == 0)
+            return g_vk_hash[h];
+        h = (h + 1) & (VK_HASH_SIZE - 1);
+    }
+    return 0;
+}
+
+const wchar_t *vk_name_from_code(int code) {
+    return VK_NAMES[code & 0xFF];
+}
+
+/* Table name, or "0xNN" for codes without one */
+void vk_format_name(int code, wchar_t *buf, int size) {
+    const wchar_t *name = VK_NAMES[code & 0xFF];
+    if (name) _snwprintf(buf, size, L"%s", name);
+    else      _snwprintf(buf, size, L"0x%02X", code & 0xFF);
+    buf[size - 1] = L'\0';
+}
@@ -0,0 +1,26 @@
+/*
+ * Copyright (c) 2026 Li Ruijie
+ * Licensed under the GNU General Public License v3.0.
+ */
+
+#ifndef W10WHEEL_VKCODE_H
+#define W10WHEEL_VKCODE_H
+
+#include <windows.h>
+
+/* Full VK name <-> code table, O(1) both ways */
+void           vk_table_init(void);
+int            vk_code_from_name(const wchar_t *name);
+const wchar_t *vk_name_from_code(int code);
+void           vk_format_name(int code, wchar_t *buf, int size);
+
+/* Keys offered as triggers in the settings dialog */
+#define VK_TRIGGER_COUNT 24
+
+static const int VK_TRIGGER_CODES[VK_TRIGGER_COUNT] = {
+    0x00, 0x09, 0x13, 0x14, 0x1C, 0x1D, 0x21, 0x22,
+    0x23, 0x24, 0x2C, 0x2D, 0x2E, 0x5B, 0x5C, 0x5D,
+    0x90, 0x91, 0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5,
+};
+
+#endif
@@ -146,14 +146,19 @@ static unsigned __stdcall waiter_proc(void *arg) {
         g_wq_tail = (g_wq_tail + 1) % WAITER_QUEUE_SIZE;
         LeaveCriticalSection(&g_wq_cs);
         ReleaseSemaphore(g_wq_space_sem, 1, NULL);
+        cfg_read_begin();
         int timeout = cfg_get_poll_timeout();
+        cfg_read_end();
 
         MouseEvent result;
-        if (sync_poll(timeout, &result)) {
+        BOOL got = sync_poll(timeout, &result);
+        cfg_read_begin();
+        if (got) {
             dispatch_event(&down, &result);
         } else {
             from_timeout(&down);
         }
+        cfg_read_end();
     }
     return 0;
 }
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2026 Li Ruijie
+ * Licensed under the GNU General Public License v3.0.
+ */
+
+/*
+ * Every batch kernel this CPU can run (batch.c) against the scalar
+ * reference on randomized batches: extreme and out-of-table deltas,
+ * thresholds at and around their edge, all swap/reverse combinations
+ * and batch lengths off the vector width.
+ */
+
+#include "batch.h"
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_COUNT 67
+
+static const int    g_thr[] = { 1, 2, 3, 5, 7, 10, 14, 20, 30, 43, 63, 91, 132, 190, 2000 };
+static const double g_mul[] = { 1.0, 1.3, 1.7, 2.0, 2.4, 2.7, 2.9, 3.3, 3.6, 3.9, 4.2, 4.5, 4.8, 5.1, 7.5 };
+#define ACCEL_COUNT ((int)(sizeof(g_thr) / sizeof(g_thr[0])))
+
+static unsigned g_rng = 2463534242u;
+
+static unsigned next_rand(void) {
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 17;
+    g_rng ^= g_rng << 5;
+    return g_rng;
+}
+
+/* In-table motion only: the vector lanes are kept, never redone in scalar */
+static int small_delta(void) {
+    return (int)(next_rand() % (2 * BATCH_LUT_SIZE - 1)) - (BATCH_LUT_SIZE - 1);
+}
+
+/* Mostly ordinary motion, salted with the values kernels get wrong */
+static int delta(void) {
+    static const int edge[] = {
+        0, 1, -1, INT_MIN, INT_MAX, INT_MIN + 1, -INT_MAX,
+        BATCH_LUT_SIZE - 1, BATCH_LUT_SIZE, BATCH_LUT_SIZE + 1,
+        -(BATCH_LUT_SIZE - 1), -BATCH_LUT_SIZE, -(BATCH_LUT_SIZE + 1),
+        1999, 2000, 2001, -2000, 1 << 30, -(1 << 30),
+    };
+    switch (next_rand() % 4) {
+    case 0:  return edge[next_rand() % (sizeof(edge) / sizeof(edge[0]))];
+    case 1:  return (int)(next_rand() % 4001) - 2000;
+    case 2:  return (int)next_rand();
+    default: return (int)(next_rand() % 41) - 20;
+    }
+}
+
+/* Totals around the threshold edge, or anywhere */
+static int total(int thr) {
+    switch (next_rand() % 4) {
+    case 0:  return thr + (int)(next_rand() % 3) - 1;
+    case 1:  return -thr + (int)(next_rand() % 3) - 1;
+    case 2:  return next_rand() % 2 ? INT_MIN : INT_MAX;
+    default: return delta();
+    }
+}
+
+int main(void) {
+    BatchMapFn fns[4];
+    const wchar_t *names[4];
+    int kernels = batch_kernels(fns, names, 4);
+    long failures = 0, checked = 0;
+
+    BatchParams *p = (BatchParams *)malloc(sizeof(BatchParams));
+    if (!p) return 1;
+
+    for (int round = 0; round < 4000; round++) {
+        int accel = round % 3 ? ACCEL_COUNT : 0;
+        BOOL reverse = (round >> 1) & 1, swap = (round >> 2) & 1, horiz = (round >> 3) & 1 || round % 5;
+        int vthr = (int)(next_rand() % 6), hthr = (int)(next_rand() % 6);
+        batch_prepare(p, g_thr, g_mul, accel, reverse, swap, vthr, hthr, horiz);
+
+        LONG xs[MAX_COUNT], ys[MAX_COUNT];
+        int tx[MAX_COUNT], ty[MAX_COUNT];
+        int count = (int)(next_rand() % (MAX_COUNT + 1));
+        BOOL tame = round % 4 == 0;
+        for (int i = 0; i < count; i++) {
+            xs[i] = tame ? small_delta() : delta();
+            ys[i] = tame ? small_delta() : delta();
+            tx[i] = total(swap ? vthr : hthr);
+            ty[i] = total(swap ? hthr : vthr);
+        }
+
+        int want_v[MAX_COUNT], want_h[MAX_COUNT];
+        batch_map_scalar(p, xs, ys, tx, ty, count, want_v, want_h);
+
+        for (int k = 1; k < kernels; k++) {
+            int v[MAX_COUNT], h[MAX_COUNT];
+            memset(v, 0x5A, sizeof(v));
+            memset(h, 0x5A, sizeof(h));
+            fns[k](p, xs, ys, tx, ty, count, v, h);
+            for (int i = 0; i < count; i++) {
+                checked++;
+                if (v[i] == want_v[i] && h[i] == want_h[i]) continue;
+                if (failures++ < 10)
+                    fprintf(stderr, "FAIL %ls round %d [%d/%d]: x %d y %d tx %d ty %d "
+                            "swap %d rev %d: got %d/%d, want %d/%d\n",
+                            names[k], round, i, count, (int)xs[i], (int)ys[i], tx[i], ty[i],
+                            swap, reverse, v[i], h[i], want_v[i], want_h[i]);
+            }
+        }
+    }
+
+    free(p);
+    printf("batch_equiv: %d kernels, %ld lanes checked, %ld failures\n",
+           kernels, checked, failures);
+    return failures != 0;
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2026 Li Ruijie
+ * Licensed under the GNU General Public License v3.0.
+ */
+
+/*
+ * Throughput of the settings file parser (iniparse.c) over a synthetic
+ * file the size of a large settings file, repeated until the timing is
+ * stable. Not a ctest: run it by hand from an optimized build.
+ */
+
+#include "iniparse.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static long g_keys = 0;
+
+static void on_key(void *ctx, const char *sec, int sec_len,
+                   const char *key, int key_len, const char *val, int val_len) {
+    (void)ctx; (void)sec; (void)sec_len; (void)key;
+    g_keys += key_len + ini_utf8_prefix(val, val_len, 1023);
+}
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv) {
+    int lines = argc > 1 ? atoi(argv[1]) : 64;
+    int reps = argc > 2 ? atoi(argv[2]) : 200000;
+
+    /* The shape of tpkb.ini: a few sections of short key = value lines, CRLF */
+    size_t cap = (size_t)lines * 64 + 256, len = 0;
+    char *buf = (char *)malloc(cap);
+    if (!buf) return 1;
+    for (int i = 0; i < lines; i++) {
+        if (i % 16 == 0)
+            len += (size_t)snprintf(buf + len, cap - len, "\r\n[Section%d]\r\n", i / 16);
+        len += (size_t)snprintf(buf + len, cap - len, "some_setting_%d = %s\r\n",
+                                i, i % 3 ? "True" : "1500");
+    }
+
+    double t0 = now_sec();
+    for (int r = 0; r < reps; r++)
+        ini_parse(buf, buf + len, on_key, NULL);
+    double dt = now_sec() - t0;
+
+    printf("bench_iniparse: %zu bytes x %d in %.3f s: %.1f MB/s, %.0f ns/file (%ld)\n",
+           len, reps, dt, (double)len * reps / dt / 1e6, dt * 1e9 / reps, g_keys);
+    free(buf);
+    return 0;
+}
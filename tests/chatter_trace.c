@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2026 Li Ruijie
+ * Licensed under the GNU General Public License v3.0.
+ */
+
+/*
+ * Traces through the keyboard chatter filter (chatter.h): the events the
+ * filter lets through must always describe a key that ends up released.
+ */
+
+#include "chatter.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define VK_A 0x41
+#define MS   30
+
+typedef struct {
+    BOOL up;
+    DWORD time;
+    int ms;
+    ChatterResult want;
+} Step;
+
+static int g_failures = 0;
+
+static void run(const char *name, const Step *steps, int n) {
+    ChatterFilter f;
+    memset(&f, 0, sizeof(f));
+    BOOL down = FALSE;      /* key state as seen past the filter */
+    for (int i = 0; i < n; i++) {
+        ChatterResult r = chatter_filter(&f, VK_A, steps[i].up, steps[i].time, steps[i].ms);
+        if (r != steps[i].want) {
+            fprintf(stderr, "FAIL %s: step %d (%s at %u): got %d, want %d\n", name, i,
+                    steps[i].up ? "up" : "down", (unsigned)steps[i].time, r, steps[i].want);
+            g_failures++;
+        }
+        if (r == CHATTER_PASS) down = !steps[i].up;
+    }
+    if (down) {
+        fprintf(stderr, "FAIL %s: key left down\n", name);
+        g_failures++;
+    }
+}
+
+#define RUN(name, ...) do { \
+    static const Step s_[] = { __VA_ARGS__ }; \
+    run(name, s_, (int)(sizeof(s_) / sizeof(s_[0]))); \
+} while (0)
+
+/*
+ * Random physical presses, holds with typematic repeats and releases,
+ * each gap sometimes inside the bounce window; the threshold may change
+ * between events as a config reload would.
+ */
+static void fuzz(unsigned seed) {
+    srand(seed);
+    for (int round = 0; round < 2000; round++) {
+        ChatterFilter f;
+        memset(&f, 0, sizeof(f));
+        BOOL down = FALSE;
+        DWORD t = 1000;
+        int n = 2 + rand() % 30;
+        BOOL phys_up = TRUE;
+        for (int i = 0; i < n || !phys_up; i++) {
+            BOOL up;
+            if (phys_up) up = FALSE;                /* press */
+            else up = (rand() % 3) == 0;            /* release or typematic repeat */
+            t += (DWORD)(rand() % 2 ? rand() % MS : rand() % 600);
+            int ms = (rand() % 8) ? MS : 0;
+            ChatterResult r = chatter_filter(&f, VK_A, up, t, ms);
+            if (r == CHATTER_PASS) {
+                if (up && !down) {
+                    fprintf(stderr, "FAIL fuzz seed %u round %d: up without a down\n", seed, round);
+                    g_failures++;
+                    return;
+                }
+                down = !up;
+            }
+            phys_up = up;
+            if (i > 200) break;
+        }
+        if (phys_up && down) {
+            fprintf(stderr, "FAIL fuzz seed %u round %d: key left down\n", seed, round);
+            g_failures++;
+            return;
+        }
+    }
+}
+
+int main(void) {
+    /* Press, release, bounce re-press, then a long hold and its release */
+    RUN("down/up/chatter-down/hold/up",
+        { FALSE, 1000, MS, CHATTER_PASS },
+        { TRUE,  1050, MS, CHATTER_PASS },
+        { FALSE, 1060, MS, CHATTER_BOUNCE },
+        { FALSE, 1560, MS, CHATTER_PASS },       /* typematic repeats */
+        { FALSE, 1593, MS, CHATTER_PASS },
+        { FALSE, 1626, MS, CHATTER_PASS },
+        { TRUE,  1700, MS, CHATTER_PASS });
+
+    /* Plain bounce: the extra down and its up both vanish */
+    RUN("bounce",
+        { FALSE, 1000, MS, CHATTER_PASS },
+        { TRUE,  1050, MS, CHATTER_PASS },
+        { FALSE, 1055, MS, CHATTER_BOUNCE },
+        { TRUE,  1057, MS, CHATTER_DROP },
+        { FALSE, 1200, MS, CHATTER_PASS },
+        { TRUE,  1300, MS, CHATTER_PASS });
+
+    /* Several bounce downs count once and share the dropped up */
+    RUN("repeated bounce",
+        { FALSE, 1000, MS, CHATTER_PASS },
+        { TRUE,  1050, MS, CHATTER_PASS },
+        { FALSE, 1055, MS, CHATTER_BOUNCE },
+        { FALSE, 1058, MS, CHATTER_DROP },
+        { TRUE,  1060, MS, CHATTER_DROP });
+
+    /* Filter turned off (pass mode, reload) during the hold */
+    RUN("disabled mid-hold",
+        { FALSE, 1000, MS, CHATTER_PASS },
+        { TRUE,  1050, MS, CHATTER_PASS },
+        { FALSE, 1060, MS, CHATTER_BOUNCE },
+        { FALSE, 1070, 0,  CHATTER_PASS },
+        { TRUE,  1400, 0,  CHATTER_PASS });
+
+    /* Threshold re-enabled while held: the open key's repeats are not bounce */
+    RUN("re-enabled mid-hold",
+        { FALSE, 1000, MS, CHATTER_PASS },
+        { TRUE,  1050, MS, CHATTER_PASS },
+        { FALSE, 1055, 0,  CHATTER_PASS },
+        { FALSE, 1070, MS, CHATTER_PASS },
+        { TRUE,  1100, MS, CHATTER_PASS });
+
+    for (unsigned seed = 1; seed <= 8; seed++)
+        fuzz(seed);
+
+    printf("chatter_trace: %d failures\n", g_failures);
+    return g_failures != 0;
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2026 Li Ruijie
+ * Licensed under the GNU General Public License v3.0.
+ */
+
+/*
+ * Minimal <windows.h> for building the portable units on a POSIX host.
+ * Covers only what those units and the tests use.
+ */
+
+#ifndef W10WHEEL_COMPAT_WINDOWS_H
+#define W10WHEEL_COMPAT_WINDOWS_H
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <wchar.h>
+
+typedef int             BOOL;
+typedef unsigned char   BYTE;
+typedef unsigned short  WORD;
+typedef unsigned short  USHORT;
+typedef uint32_t        DWORD;
+typedef int32_t         LONG;
+typedef int64_t         LONG64;
+typedef int64_t         LONGLONG;
+typedef uint32_t        UINT;
+typedef void           *PVOID;
+
+#define TRUE  1
+#define FALSE 0
+
+#define DECLSPEC_ALIGN(n) __attribute__((aligned(n)))
+
+typedef struct { LONG left, top, right, bottom; } RECT;
+
+#define MOUSE_MOVE_ABSOLUTE      0x01
+#define MOUSE_VIRTUAL_DESKTOP    0x02
+#define MOUSE_ATTRIBUTES_CHANGED 0x04
+
+#define InterlockedIncrement(p)                 __atomic_add_fetch((p), 1, __ATOMIC_SEQ_CST)
+#define InterlockedDecrement(p)                 __atomic_sub_fetch((p), 1, __ATOMIC_SEQ_CST)
+#define InterlockedExchange(p, v)               __atomic_exchange_n((p), (v), __ATOMIC_SEQ_CST)
+#define InterlockedExchange64(p, v)             __atomic_exchange_n((p), (v), __ATOMIC_SEQ_CST)
+#define InterlockedExchangePointer(p, v)        __atomic_exchange_n((p), (v), __ATOMIC_SEQ_CST)
+#define InterlockedExchangeAdd64(p, v)          __atomic_fetch_add((p), (v), __ATOMIC_SEQ_CST)
+#define InterlockedOr(p, v)                     __atomic_fetch_or((p), (v), __ATOMIC_SEQ_CST)
+#define InterlockedAnd(p, v)                    __atomic_fetch_and((p), (v), __ATOMIC_SEQ_CST)
+#define MemoryBarrier()                         __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+static inline LONG InterlockedCompareExchange(volatile LONG *p, LONG v, LONG cmp) {
+    __atomic_compare_exchange_n(p, &cmp, v, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    return cmp;
+}
+
+static inline PVOID InterlockedCompareExchangePointer(PVOID volatile *p, PVOID v, PVOID cmp) {
+    __atomic_compare_exchange_n(p, &cmp, v, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    return cmp;
+}
+
+/* Critical sections are recursive, like the Win32 ones */
+typedef pthread_mutex_t CRITICAL_SECTION;
+
+static inline void InitializeCriticalSection(CRITICAL_SECTION *cs) {
+    pthread_mutexattr_t a;
+    pthread_mutexattr_init(&a);
+    pthread_mutexattr_settype(&a, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(cs, &a);
+    pthread_mutexattr_destroy(&a);
+}
+#define DeleteCriticalSection(cs)   pthread_mutex_destroy(cs)
+#define EnterCriticalSection(cs)    pthread_mutex_lock(cs)
+#define LeaveCriticalSection(cs)    pthread_mutex_unlock(cs)
+
+static inline DWORD GetTickCount(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (DWORD)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+static inline DWORD GetCurrentThreadId(void) {
+    static __thread DWORD id;
+    static DWORD next;
+    if (!id) id = __atomic_add_fetch(&next, 1, __ATOMIC_SEQ_CST);
+    return id;
+}
+
+static inline void Sleep(DWORD ms) {
+    if (ms == 0) sched_yield();
+    else usleep((useconds_t)ms * 1000);
+}
+
+#endif
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2026 Li Ruijie
+ * Licensed under the GNU General Public License v3.0.
+ */
+
+/*
+ * Fuzz target for the settings file parser (iniparse.c). Built with
+ * -fsanitize=fuzzer it is a libFuzzer target; otherwise a deterministic
+ * driver feeds it generated and mutated INI text, so ctest runs it too.
+ * Besides memory errors, every reported span must lie in the input and
+ * obey the trimming rules, and UTF-8 prefixes must never split a
+ * sequence.
+ */
+
+#include "iniparse.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    const char *begin, *end;
+    long keys;
+} Input;
+
+static void fail(const char *what) {
+    fprintf(stderr, "FAIL: %s\n", what);
+    abort();
+}
+
+static int is_blank(char c) { return c == ' ' || c == '\t'; }
+
+static void check_span(const Input *in, const char *s, int len, const char *what) {
+    if (len <= 0 || s < in->begin || s + len > in->end) fail(what);
+    if (memchr(s, '\n', (size_t)len)) fail(what);
+}
+
+static void on_key(void *ctx, const char *sec, int sec_len,
+                   const char *key, int key_len, const char *val, int val_len) {
+    Input *in = (Input *)ctx;
+    check_span(in, sec, sec_len, "section span");
+    check_span(in, key, key_len, "key span");
+    check_span(in, val, val_len, "value span");
+    if (is_blank(key[0]) || is_blank(key[key_len - 1])) fail("key not trimmed");
+    if (is_blank(val[0]) || is_blank(val[val_len - 1])) fail("value not trimmed");
+    if (key[0] == '#' || key[0] == ';' || key[0] == '[') fail("comment or section parsed as key");
+    if (memchr(key, '=', (size_t)key_len)) fail("key contains '='");
+    if (val[val_len - 1] == '\r' && val + val_len < in->end && val[val_len] == '\n')
+        fail("CR of CRLF kept in value");
+
+    for (int max = 0; max <= val_len + 1; max += 1 + max / 4) {
+        int n = ini_utf8_prefix(val, val_len, max);
+        if (n < 0 || n > max || n > val_len) fail("prefix length");
+        if (n < val_len && ((unsigned char)val[n] & 0xC0) == 0x80 && n > 0) fail("prefix splits UTF-8");
+        if (val_len <= max && n != val_len) fail("prefix cut a short value");
+    }
+    in->keys++;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    /* Exact-size copy: reads past the end trip ASan */
+    char *buf = (char *)malloc(size ? size : 1);
+    if (!buf) return 0;
+    if (size) memcpy(buf, data, size);
+    Input in = { buf, buf + size, 0 };
+    ini_parse(buf, buf + size, on_key, &in);
+    free(buf);
+    return 0;
+}
+
+#ifndef TPKB_LIBFUZZER
+
+static const char *const g_pieces[] = {
+    "[General]", "[Scroll]", "[", "]", "[]", "key", "trigger", "=", " = ", "==",
+    "value", "True", "500", " ", "\t", "\r\n", "\n", "\r", "#", ";", "\xEF\xBB\xBF",
+    "\xC3\xA9", "\xE2\x82\xAC", "\xF0\x9F\x98\x80", "\x80", "\xC3", "\0",
+};
+#define PIECE_COUNT ((int)(sizeof(g_pieces) / sizeof(g_pieces[0])))
+
+static uint32_t g_rng = 12345;
+
+static uint32_t next_rand(void) {
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 17;
+    g_rng ^= g_rng << 5;
+    return g_rng;
+}
+
+int main(void) {
+    static uint8_t buf[4096];
+    for (int round = 0; round < 200000; round++) {
+        size_t len = 0;
+        int pieces = (int)(next_rand() % 48);
+        for (int i = 0; i < pieces; i++) {
+            int k = (int)(next_rand() % PIECE_COUNT);
+            size_t n = k == PIECE_COUNT - 1 ? 1 : strlen(g_pieces[k]);
+            if (len + n > sizeof(buf)) break;
+            memcpy(buf + len, g_pieces[k], n);
+            len += n;
+        }
+        /* Flip a few bytes */
+        for (int i = 0; len && i < (int)(next_rand() % 3); i++)
+            buf[next_rand() % len] = (uint8_t)next_rand();
+        LLVMFuzzerTestOneInput(buf, len);
+    }
+
+    /* A known file parses to its keys */
+    const char *ini = "\xEF\xBB\xBF# c\r\n[General]\r\n trigger = LR \r\nbad\r\n=x\r\nk=\r\n[S]\nv\t=\t1";
+    Input in = { ini, ini + strlen(ini), 0 };
+    ini_parse(ini, ini + strlen(ini), on_key, &in);
+    if (in.keys != 2) fail("known file key count");
+
+    printf("fuzz_iniparse: ok\n");
+    return 0;
+}
+
+#endif
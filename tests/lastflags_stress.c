@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2026 Li Ruijie
+ * Licensed under the GNU General Public License v3.0.
+ */
+
+/*
+ * Concurrency stress of the LastFlags bitsets (lastflags.h). Like the
+ * hook and waiter threads, one thread sets a flag and two race to
+ * get-and-reset it, for several mouse bits in the mouse word and several
+ * VK codes sharing one keyboard word, all at once; another thread keeps
+ * setting and clearing the neighbouring bits (as cfg_last_flags_reset_lr
+ * does). Every set must be consumed exactly once: a lost set stalls its
+ * setter, a double consume is caught by the consumer.
+ */
+
+#include "lastflags.h"
+#include <stdio.h>
+
+#define ROUNDS      20000
+#define CONSUMERS   2
+#define STALL_MS    5000
+
+typedef struct {
+    const char *name;
+    LONG        bit;        /* mouse bit, or 0 for a key */
+    int         vk;
+    volatile LONG sets;
+    volatile LONG consumed;
+} Flag;
+
+static LastFlags g_flags;
+static volatile LONG g_failures = 0;
+static volatile LONG g_stop = 0;
+
+/* Mouse bits and VK codes 0x41..0x44, which share kd_suppressed[2] */
+static Flag g_tracked[] = {
+    { "LF_LD_RESENT",     LF_LD_RESENT,     0,    0, 0 },
+    { "LF_RD_PASSED",     LF_RD_PASSED,     0,    0, 0 },
+    { "LF_LD_SUPPRESSED", LF_LD_SUPPRESSED, 0,    0, 0 },
+    { "LF_SD_SUPPRESSED", LF_SD_SUPPRESSED, 0,    0, 0 },
+    { "VK 0x41",          0,                0x41, 0, 0 },
+    { "VK 0x42",          0,                0x42, 0, 0 },
+    { "VK 0x43",          0,                0x43, 0, 0 },
+    { "VK 0x5F",          0,                0x5F, 0, 0 },
+};
+#define TRACKED ((int)(sizeof(g_tracked) / sizeof(g_tracked[0])))
+
+/* Churned by the neighbour thread: the same words, other bits */
+#define NEIGHBOUR_MOUSE  (LF_RD_RESENT | LF_LD_PASSED | LF_RD_SUPPRESSED)
+static const int g_neighbour_vks[] = { 0x40, 0x44, 0x45, 0x5E };
+
+static void fail(const Flag *f, const char *what) {
+    fprintf(stderr, "FAIL %s: %s (sets %ld, consumed %ld)\n",
+            f->name, what, (long)f->sets, (long)f->consumed);
+    InterlockedIncrement(&g_failures);
+    InterlockedExchange(&g_stop, 1);
+}
+
+static void flag_set(Flag *f) {
+    if (f->bit) lf_set(&g_flags.mouse, f->bit);
+    else        lf_set_key(&g_flags, f->vk);
+}
+
+static BOOL flag_get_reset(Flag *f) {
+    return f->bit ? lf_get_reset(&g_flags.mouse, f->bit) : lf_get_reset_key(&g_flags, f->vk);
+}
+
+/* Hook thread role: a down sets the flag once its previous up consumed it */
+static void *setter(void *arg) {
+    Flag *f = (Flag *)arg;
+    for (LONG n = 1; n <= ROUNDS && !g_stop; n++) {
+        DWORD start = GetTickCount();
+        while (__atomic_load_n(&f->consumed, __ATOMIC_SEQ_CST) != n - 1) {
+            if (g_stop) return NULL;
+            if (GetTickCount() - start > STALL_MS) {
+                fail(f, "set lost: never consumed");
+                return NULL;
+            }
+            sched_yield();
+        }
+        InterlockedExchange(&f->sets, n);
+        flag_set(f);
+    }
+    return NULL;
+}
+
+/* Hook or waiter thread role: the matching up consumes the flag */
+static void *consumer(void *arg) {
+    Flag *f = (Flag *)arg;
+    unsigned seed = (unsigned)(uintptr_t)&seed;
+    while (!g_stop && __atomic_load_n(&f->consumed, __ATOMIC_SEQ_CST) < ROUNDS) {
+        /* Late ups keep flags pending while other flags in the word change */
+        for (int y = (int)((seed = seed * 1103515245u + 12345u) >> 28); y > 0; y--)
+            sched_yield();
+        if (!flag_get_reset(f)) {
+            sched_yield();
+            continue;
+        }
+        LONG c = InterlockedIncrement(&f->consumed);
+        if (c > __atomic_load_n(&f->sets, __ATOMIC_SEQ_CST))
+            fail(f, "get_reset returned TRUE twice for one set");
+    }
+    return NULL;
+}
+
+static void *neighbour(void *arg) {
+    (void)arg;
+    int n = (int)(sizeof(g_neighbour_vks) / sizeof(g_neighbour_vks[0]));
+    for (unsigned i = 0; !__atomic_load_n(&g_stop, __ATOMIC_SEQ_CST); i++) {
+        lf_set(&g_flags.mouse, NEIGHBOUR_MOUSE);
+        InterlockedAnd(&g_flags.mouse, ~NEIGHBOUR_MOUSE);
+        lf_set_key(&g_flags, g_neighbour_vks[i % n]);
+        lf_get_reset_key(&g_flags, g_neighbour_vks[(i + 1) % n]);
+        if (i % 16 == 0) sched_yield();
+    }
+    return NULL;
+}
+
+int main(void) {
+    pthread_t setters[TRACKED], consumers[TRACKED][CONSUMERS], churn;
+    pthread_create(&churn, NULL, neighbour, NULL);
+    for (int i = 0; i < TRACKED; i++) {
+        pthread_create(&setters[i], NULL, setter, &g_tracked[i]);
+        for (int c = 0; c < CONSUMERS; c++)
+            pthread_create(&consumers[i][c], NULL, consumer, &g_tracked[i]);
+    }
+
+    for (int i = 0; i < TRACKED; i++) {
+        pthread_join(setters[i], NULL);
+        for (int c = 0; c < CONSUMERS; c++)
+            pthread_join(consumers[i][c], NULL);
+    }
+    InterlockedExchange(&g_stop, 1);
+    pthread_join(churn, NULL);
+
+    for (int i = 0; i < TRACKED; i++)
+        if (!g_failures && g_tracked[i].consumed != ROUNDS)
+            fail(&g_tracked[i], "not every set consumed");
+
+    printf("lastflags_stress: %d flags x %d sets, %ld failures\n",
+           TRACKED, ROUNDS, (long)g_failures);
+    return g_failures != 0;
+}
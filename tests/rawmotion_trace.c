@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2026 Li Ruijie
+ * Licensed under the GNU General Public License v3.0.
+ */
+
+/*
+ * Raw report to delta conversion (rawmotion.h) over a trace of reports
+ * as a pen, an RDP session or a VM pointer sends them: relative and
+ * absolute reports interleaved, a switch to virtual-desktop coordinates,
+ * attribute change notices and a new session. Each step checks whether
+ * motion is sent and how much.
+ */
+
+#include "rawmotion.h"
+#include <stdio.h>
+#include <string.h>
+
+#define REL  0
+#define ABS  MOUSE_MOVE_ABSOLUTE
+#define VD   (MOUSE_MOVE_ABSOLUTE | MOUSE_VIRTUAL_DESKTOP)
+#define ATTR MOUSE_ATTRIBUTES_CHANGED
+
+typedef struct {
+    const char *what;
+    LONG session;
+    USHORT flags;
+    LONG x, y;
+    BOOL sent;
+    LONG dx, dy;
+} Step;
+
+/* Primary 1920x1080 at the origin, a second 1280x1024 monitor to its left */
+static const RawScreens g_screens = {
+    { 0, 0, 1920, 1080 },
+    { -1280, 0, 1920, 1080 },
+};
+
+/* 0..65535 over the virtual desktop for a pixel, rounded up so it maps back exactly */
+static LONG vd_x(LONG px) { return (LONG)((((LONGLONG)px + 1280) * 65535 + 3199) / 3200); }
+static LONG vd_y(LONG py) { return (LONG)(((LONGLONG)py * 65535 + 1079) / 1080); }
+
+int main(void) {
+    const Step trace[] = {
+        { "relative",                  1, REL,  5, -3,            TRUE,  5, -3 },
+        { "first absolute: origin",    1, ABS,  32768, 32768,     FALSE, 0, 0 },
+        { "absolute",                  1, ABS,  32768, 33375,     TRUE,  0, 10 },
+        { "absolute back",             1, ABS,  32768, 32768,     TRUE,  0, -10 },
+        { "attribute change",          1, ATTR, 1000, 1000,       FALSE, 0, 0 },
+        { "attribute change absolute", 1, ABS | ATTR, 0, 0,       FALSE, 0, 0 },
+        { "absolute after notices",    1, ABS,  32768, 33375,     TRUE,  0, 10 },
+        { "interleaved relative",      1, REL,  0, 7,             TRUE,  0, 7 },
+        { "absolute after relative",   1, ABS,  32768, 32768,     FALSE, 0, 0 },
+        { "absolute",                  1, ABS,  32768, 32162,     TRUE,  0, -10 },
+        /* Same physical point (960, 530) in virtual-desktop coordinates */
+        { "switch to virtual desktop", 1, VD,   vd_x(960), vd_y(530), TRUE, 0, 0 },
+        { "virtual desktop",           1, VD,   vd_x(960), vd_y(550), TRUE, 0, 20 },
+        { "virtual desktop, left",     1, VD,   vd_x(-640), vd_y(550), TRUE, -1600, 0 },
+        { "switch back to primary",    1, ABS,  0, 33375,         TRUE,  640, 0 },
+        { "new session: origin",       2, ABS,  32768, 33375,     FALSE, 0, 0 },
+        { "new session",               2, ABS,  32768, 32768,     TRUE,  0, -10 },
+    };
+
+    RawAbsPosition pos = { -1, 0, 0 };
+    int failures = 0;
+    for (size_t i = 0; i < sizeof(trace) / sizeof(trace[0]); i++) {
+        const Step *s = &trace[i];
+        RawAbsPosition before = pos;
+        LONG dx = 0, dy = 0;
+        BOOL sent = raw_motion_delta(&pos, s->session, s->flags, s->x, s->y, &g_screens, &dx, &dy);
+        if (sent != s->sent || (sent && (dx != s->dx || dy != s->dy))) {
+            fprintf(stderr, "FAIL step %zu (%s): sent %d (%ld, %ld), want %d (%ld, %ld)\n",
+                    i, s->what, sent, (long)dx, (long)dy, s->sent, (long)s->dx, (long)s->dy);
+            failures++;
+        }
+        if ((s->flags & ATTR) && memcmp(&before, &pos, sizeof(pos)) != 0) {
+            fprintf(stderr, "FAIL step %zu (%s): attribute change moved the origin\n", i, s->what);
+            failures++;
+        }
+    }
+
+    printf("rawmotion_trace: %zu steps, %d failures\n", sizeof(trace) / sizeof(trace[0]), failures);
+    return failures != 0;
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2026 Li Ruijie
+ * Licensed under the GNU General Public License v3.0.
+ */
+
+/*
+ * Software repeat schedule (repeatsched.h) against a virtual clock in
+ * microseconds. The timer thread is modelled as waking at each deadline
+ * plus an injected lateness; the traces check that lateness never adds
+ * up into drift and that a stall never turns into a burst of repeats.
+ */
+
+#include "repeatsched.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define DELAY     500000    /* us */
+#define INTERVAL  33333
+#define ARMED     1000000
+#define REPEATS   10000
+
+static int g_failures = 0;
+
+static void check(int ok, const char *trace, const char *what, long long got, long long want) {
+    if (ok) return;
+    fprintf(stderr, "FAIL %s: %s: got %lld, want %lld\n", trace, what, got, want);
+    g_failures++;
+}
+
+/* Most repeats sent within one interval of any instant: 2 is jitter, more is a burst */
+static int max_per_interval(const LONGLONG *sent, int n) {
+    int worst = 0;
+    for (int i = 0, j = 0; i < n; i++) {
+        while (sent[i] - sent[j] >= INTERVAL) j++;
+        if (i - j + 1 > worst) worst = i - j + 1;
+    }
+    return worst;
+}
+
+/*
+ * Runs REPEATS repeats; late(i) is how far past its deadline repeat i is
+ * sent. Returns the send times in sent[].
+ */
+static RepeatSchedule run(LONGLONG (*late)(int), LONGLONG *sent) {
+    RepeatSchedule s;
+    repeat_sched_start(&s, ARMED, DELAY, INTERVAL);
+    for (int i = 0; i < REPEATS; i++) {
+        LONGLONG now = s.next + late(i);
+        sent[i] = now;
+        repeat_sched_fired(&s, now);
+    }
+    return s;
+}
+
+static LONGLONG on_time(int i) { (void)i; return 0; }
+
+/* Up to one interval late, uniformly: the timer's jitter under load */
+static LONGLONG jitter(int i) { (void)i; return rand() % INTERVAL; }
+
+/* Always nearly a whole interval late */
+static LONGLONG worst_jitter(int i) { (void)i; return INTERVAL - 1; }
+
+/* On time, except one long stall (debugger, suspend) at repeat 100 */
+static LONGLONG stall(int i) { return i == 100 ? 5 * INTERVAL + INTERVAL / 2 : 0; }
+
+/* Jitter plus stalls of one to three intervals */
+static LONGLONG stall_jitter(int i) {
+    return i % 97 == 0 ? INTERVAL + rand() % (2 * INTERVAL) : rand() % INTERVAL;
+}
+
+int main(void) {
+    static LONGLONG sent[REPEATS];
+    srand(7);
+
+    /* First repeat at armed + delay, then exactly every interval */
+    RepeatSchedule s = run(on_time, sent);
+    check(sent[0] == ARMED + DELAY, "on time", "first repeat", sent[0], ARMED + DELAY);
+    check(sent[REPEATS - 1] - sent[0] == (LONGLONG)(REPEATS - 1) * INTERVAL, "on time",
+          "span", sent[REPEATS - 1] - sent[0], (LONGLONG)(REPEATS - 1) * INTERVAL);
+
+    /* Lateness below one interval: the deadlines stay on the original grid */
+    const char *names[] = { "jitter", "worst jitter" };
+    LONGLONG (*lates[])(int) = { jitter, worst_jitter };
+    for (int t = 0; t < 2; t++) {
+        s = run(lates[t], sent);
+        LONGLONG grid = ARMED + DELAY + (LONGLONG)REPEATS * INTERVAL;
+        check(s.next == grid, names[t], "cumulative drift (next deadline)", s.next, grid);
+        int burst = max_per_interval(sent, REPEATS);
+        check(burst <= 2, names[t], "repeats within one interval", burst, 2);
+    }
+
+    /* A stall: the missed repeats are skipped, the next one a full interval later */
+    s = run(stall, sent);
+    check(sent[101] - sent[100] == INTERVAL, "stall", "gap after the stall",
+          sent[101] - sent[100], INTERVAL);
+    check(max_per_interval(sent, REPEATS) == 1, "stall", "repeats within one interval",
+          max_per_interval(sent, REPEATS), 1);
+    check(sent[REPEATS - 1] - sent[101] == (LONGLONG)(REPEATS - 102) * INTERVAL, "stall",
+          "drift after resync", sent[REPEATS - 1] - sent[101], (LONGLONG)(REPEATS - 102) * INTERVAL);
+
+    /* Stalls among jitter: never a burst, and every gap after a stall is a full interval */
+    s = run(stall_jitter, sent);
+    int burst = max_per_interval(sent, REPEATS);
+    check(burst <= 2, "stall + jitter", "repeats within one interval", burst, 2);
+    for (int i = 97; i + 1 < REPEATS; i += 97)
+        check(sent[i + 1] - sent[i] >= INTERVAL, "stall + jitter", "gap after a stall",
+              sent[i + 1] - sent[i], INTERVAL);
+
+    printf("repeatsched_trace: %d failures\n", g_failures);
+    return g_failures != 0;
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2026 Li Ruijie
+ * Licensed under the GNU General Public License v3.0.
+ */
+
+/*
+ * Exhaustive interleavings of the scroll start/exit handshake
+ * (runstate.h) between its two threads, at the granularity of single
+ * loads and CASes:
+ *
+ *   hook:   rs_starting; then cfg_exit_scroll_deferred on the second up
+ *           (load; exit if MODE, else CAS rs_defer_exit and retry on failure)
+ *   waiter: cfg_start_scroll (rs_start), exiting if RS_EXIT_PENDING came back
+ *
+ * Every schedule must exit exactly once and leave no session bits behind.
+ */
+
+#include "runstate.h"
+#include <stdio.h>
+
+/* Hook program counter */
+enum { H_STARTING, H_LOAD, H_DECIDE, H_DONE };
+/* Waiter program counter */
+enum { W_START, W_EXIT, W_DONE };
+
+typedef struct {
+    LONG state;
+    int  hook_pc, waiter_pc;
+    LONG hook_old;      /* value loaded by cfg_exit_scroll_deferred */
+    LONG waiter_st;     /* value returned by rs_start */
+    int  exits;
+    int  trace[16];
+    int  steps;
+} World;
+
+static int g_schedules = 0;
+static int g_failures = 0;
+
+static void report(const World *w, LONG base) {
+    fprintf(stderr, "FAIL: base=%#x exits=%d final=%#x trace=", (unsigned)base,
+            w->exits, (unsigned)w->state);
+    for (int i = 0; i < w->steps; i++)
+        fputc(w->trace[i] ? 'W' : 'H', stderr);
+    fputc('\n', stderr);
+}
+
+static BOOL step_hook(World *w) {
+    switch (w->hook_pc) {
+    case H_STARTING:
+        w->state = rs_starting(w->state);
+        w->hook_pc = H_LOAD;
+        return TRUE;
+    case H_LOAD:
+        w->hook_old = w->state;
+        w->hook_pc = H_DECIDE;
+        return TRUE;
+    case H_DECIDE:
+        if (w->hook_old & RS_SCROLL_MODE) {
+            w->state = rs_exit(w->state);
+            w->exits++;
+            w->hook_pc = H_DONE;
+        } else if (w->state == w->hook_old) {
+            w->state = rs_defer_exit(w->hook_old);
+            w->hook_pc = H_DONE;
+        } else {
+            w->hook_pc = H_LOAD;    /* CAS failed */
+        }
+        return TRUE;
+    default:
+        return FALSE;
+    }
+}
+
+static BOOL step_waiter(World *w) {
+    switch (w->waiter_pc) {
+    case W_START:
+        w->state = rs_start(w->state);
+        w->waiter_st = w->state;
+        w->waiter_pc = (w->waiter_st & RS_EXIT_PENDING) ? W_EXIT : W_DONE;
+        return TRUE;
+    case W_EXIT:
+        w->state = rs_exit(w->state);
+        w->exits++;
+        w->waiter_pc = W_DONE;
+        return TRUE;
+    default:
+        return FALSE;
+    }
+}
+
+static void explore(World w, LONG base) {
+    BOOL any = FALSE;
+    for (int who = 0; who < 2; who++) {
+        World next = w;
+        if (!(who ? step_waiter(&next) : step_hook(&next))) continue;
+        if (next.steps < 16) next.trace[next.steps] = who;
+        next.steps++;
+        explore(next, base);
+        any = TRUE;
+    }
+    if (any) return;
+
+    g_schedules++;
+    LONG session = RS_SCROLL_MODE | RS_SCROLL_STARTING | RS_EXIT_PENDING;
+    if (w.exits != 1 || (w.state & session) || (w.state & ~session) != (base & ~session)) {
+        g_failures++;
+        report(&w, base);
+    }
+}
+
+int main(void) {
+    /* Unrelated bits must survive every transition */
+    static const LONG bases[] = { 0, RS_DRAGGED, RS_DRAG_PRE_SCROLL };
+    for (int i = 0; i < (int)(sizeof(bases) / sizeof(bases[0])); i++) {
+        World w = {0};
+        w.state = bases[i];
+        explore(w, bases[i]);
+    }
+    printf("runstate_trace: %d schedules, %d failures\n", g_schedules, g_failures);
+    return g_failures != 0;
+}